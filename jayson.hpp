@@ -2,13 +2,50 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <unordered_map>
 #include <sstream>
 #include <fstream>
+#include <memory>
 #include <iomanip>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <cfloat>
+#include <clocale>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <tuple>
+#include <cstdio>
+#include <cerrno>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+#if !defined(JAYSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JAYSON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JAYSON_POSIX 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if !defined(JAYSON_NO_SIMD) && (defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define JAYSON_SWAR 1
+#endif
 
 namespace json
 {
@@ -22,7 +59,8 @@ struct serialize_options
 	bool        java_style_braces = false;
 	bool        utf8_escaping     = true;
 	std::string indent            = "  ";
-	int         number_precision  = 2;
+	int         number_precision  = 2; // digits after the point, -1 for the shortest form that reads back exactly
+	unsigned    threads           = 1; // large arrays and objects are formatted in ranges on this many threads, 0 for one per core
 
 	static serialize_options& global()
 	{
@@ -31,6 +69,38 @@ struct serialize_options
 	}
 };
 
+// receives serialized output in pieces, returns false to report a write error
+using write_sink = bool (*)(void* context, char const* data, std::size_t size);
+
+class string_pool;
+
+struct parse_options
+{
+	// Strings refer to the parsed buffer instead of being copied, so the buffer must outlive
+	// the result. Strings with escapes are decoded into a copy while parsing, and object keys
+	// are always copied. Borrowed strings are not zero terminated, see as<char const*>().
+	bool in_situ = false;
+
+	// Strings must be well-formed UTF-8: no overlong forms, surrogates or code points above
+	// U+10FFFF. Runs of ASCII are checked 16 bytes at a time.
+	bool validate_utf8 = false;
+
+	// String values up to pool_limit bytes are shared through the pool instead of being copied
+	// per value, so it must outlive the result. Object keys are still copied.
+	string_pool* pool       = nullptr;
+	std::size_t  pool_limit = 64;
+
+	// A top-level array is split between elements and parsed by this many threads, 0 for one
+	// per core. Only large arrays are split, and never when parsing into a document's arena.
+	unsigned threads = 1;
+
+	static parse_options& global()
+	{
+		static parse_options g_options;
+		return g_options;
+	}
+};
+
 enum class type : char
 {
 	null     = ' ',
@@ -38,12 +108,291 @@ enum class type : char
 	n_double = 'f',
 	n_int32  = 'i',
 	n_int64  = 'l',
+	n_uint64 = 'u',
 	string   = 's',
 	binary   = 'x',
 	array    = 'a',
 	object   = 'o'
 };
 
+// non-owning reference to string data, valid while the source value is alive and unchanged
+struct string_ref
+{
+	char const* ptr = "";
+	std::size_t len = 0;
+
+	string_ref() = default;
+	string_ref(char const* p, std::size_t n) : ptr(p), len(n) {}
+
+	char const* data()  const { return ptr; }
+	std::size_t size()  const { return len; }
+	bool        empty() const { return len == 0; }
+	char const* begin() const { return ptr; }
+	char const* end()   const { return ptr + len; }
+
+	operator std::string () const { return std::string(ptr, len); }
+
+	bool operator == (string_ref const& r) const { return len == r.len && memcmp(ptr, r.ptr, len) == 0; }
+	bool operator != (string_ref const& r) const { return !(*this == r); }
+};
+
+// monotonic allocator: memory is handed out in order and released all at once
+class arena
+{
+public:
+
+	arena() = default;
+	explicit arena(std::size_t block_size) : m_block_size(block_size) {}
+	~arena() { release(); }
+
+	arena(arena const&) = delete;
+	arena& operator = (arena const&) = delete;
+
+	void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t))
+	{
+		uintptr_t pos = align_up(reinterpret_cast<uintptr_t>(m_ptr), align);
+		if (!m_head || pos + size > reinterpret_cast<uintptr_t>(m_end))
+		{
+			grow(size + align);
+			pos = align_up(reinterpret_cast<uintptr_t>(m_ptr), align);
+		}
+		m_ptr = reinterpret_cast<char*>(pos + size);
+		return reinterpret_cast<void*>(pos);
+	}
+
+	template <typename T, typename... Args> T* create(Args&&... args)
+	{
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	char const* copy(char const* str, std::size_t len)
+	{
+		char* dst = static_cast<char*>(allocate(len + 1, 1));
+		memcpy(dst, str, len);
+		dst[len] = '\0';
+		return dst;
+	}
+
+	// frees everything but the last (largest) block, so a reused arena stops allocating
+	void reset()
+	{
+		if (m_head)
+		{
+			free_blocks(m_head->prev);
+			m_head->prev = nullptr;
+			m_ptr = reinterpret_cast<char*>(m_head + 1);
+		}
+	}
+
+	void release()
+	{
+		free_blocks(m_head);
+		m_head = nullptr;
+		m_ptr = m_end = nullptr;
+	}
+
+private:
+
+	struct block
+	{
+		block*      prev;
+		std::size_t size;
+	};
+
+	block*      m_head = nullptr;
+	char*       m_ptr = nullptr;
+	char*       m_end = nullptr;
+	std::size_t m_block_size = 4096;
+
+	static uintptr_t align_up(uintptr_t pos, std::size_t align) { return (pos + align - 1) & ~static_cast<uintptr_t>(align - 1); }
+
+	void grow(std::size_t min_size)
+	{
+		std::size_t size = m_head ? m_head->size * 2 : m_block_size;
+		while (size < min_size + sizeof(block)) size *= 2;
+		block* b = static_cast<block*>(::operator new(size));
+		b->prev = m_head;
+		b->size = size;
+		m_head = b;
+		m_ptr = reinterpret_cast<char*>(b + 1);
+		m_end = reinterpret_cast<char*>(b) + size;
+	}
+
+	static void free_blocks(block* b)
+	{
+		while (b)
+		{
+			block* prev = b->prev;
+			::operator delete(b);
+			b = prev;
+		}
+	}
+};
+
+// FNV-1a
+inline uint32_t key_hash(char const* key, std::size_t len)
+{
+	uint32_t h = 2166136261u;
+	for (std::size_t i=0; i<len; ++i) h = (h ^ static_cast<uint8_t>(key[i])) * 16777619u;
+	return h;
+}
+
+// MARK: keys
+// An object key with its length and hash worked out up front. Declared constexpr, or written
+// as "name"_key, it is hashed at compile time, so lookups with it neither allocate nor hash:
+//     static constexpr json::key id("id");
+//     int n = object(id);
+// The characters are not copied and must outlive the key.
+struct key
+{
+	char const* ptr;
+	std::size_t len;
+	uint32_t    hash;
+
+	constexpr key(char const* str) : key(str, length(str)) {}
+	constexpr key(char const* str, std::size_t n) : ptr(str), len(n), hash(fnv1a(str, n, 2166136261u)) {}
+	key(std::string const& str) : ptr(str.data()), len(str.size()), hash(key_hash(str.data(), str.size())) {}
+
+	constexpr char const* data() const { return ptr; }
+	constexpr std::size_t size() const { return len; }
+
+private:
+
+	friend class path;
+	key(char const* str, std::size_t n, uint32_t h) : ptr(str), len(n), hash(h) {}
+
+	// recursive, because constexpr functions may not loop in C++11
+	static constexpr std::size_t length(char const* str, std::size_t n = 0) { return str[n] ? length(str, n + 1) : n; }
+	static constexpr uint32_t fnv1a(char const* str, std::size_t n, uint32_t h)
+	{
+		return n == 0 ? h : fnv1a(str + 1, n - 1, (h ^ static_cast<uint8_t>(*str)) * 16777619u);
+	}
+};
+
+inline namespace literals
+{
+	constexpr key operator "" _key(char const* str, std::size_t len) { return key(str, len); }
+}
+
+// MARK: string pool
+// One immutable, zero terminated copy per distinct string. Nothing is freed before the pool,
+// so it must outlive every value that refers to it. Interning is safe from several threads;
+// strings are spread over independently locked shards.
+class string_pool
+{
+public:
+
+	string_pool() = default;
+	string_pool(string_pool const&) = delete;
+	string_pool& operator = (string_pool const&) = delete;
+
+	string_ref intern(char const* str, std::size_t len)
+	{
+		uint32_t h = key_hash(str, len);
+		shard& sh = m_shards[h >> (32 - shard_bits)];
+		std::lock_guard<std::mutex> lock(sh.lock);
+		if ((sh.count + 1) * 2 > sh.table.size()) sh.grow();
+		std::size_t mask = sh.table.size() - 1;
+		for (std::size_t pos = h & mask;; pos = (pos + 1) & mask)
+		{
+			entry& e = sh.table[pos];
+			if (!e.ptr)
+			{
+				e.ptr  = sh.memory.copy(str, len);
+				e.len  = len;
+				e.hash = h;
+				++sh.count;
+				return string_ref(e.ptr, len);
+			}
+			if (e.hash == h && e.len == len && memcmp(e.ptr, str, len) == 0) return string_ref(e.ptr, len);
+		}
+	}
+
+	string_ref intern(string_ref const& str) { return intern(str.data(), str.size()); }
+
+	// number of distinct strings
+	std::size_t size()
+	{
+		std::size_t n = 0;
+		for (auto& sh : m_shards)
+		{
+			std::lock_guard<std::mutex> lock(sh.lock);
+			n += sh.count;
+		}
+		return n;
+	}
+
+private:
+
+	static constexpr unsigned shard_bits = 4;
+
+	struct entry
+	{
+		char const* ptr = nullptr;
+		std::size_t len = 0;
+		uint32_t    hash = 0;
+	};
+
+	struct shard
+	{
+		std::mutex         lock;
+		arena              memory;
+		std::vector<entry> table;
+		std::size_t        count = 0;
+
+		void grow()
+		{
+			std::vector<entry> old(table.empty() ? 64 : table.size() * 2);
+			old.swap(table);
+			std::size_t mask = table.size() - 1;
+			for (auto const& e : old)
+			{
+				if (!e.ptr) continue;
+				std::size_t pos = e.hash & mask;
+				while (table[pos].ptr) pos = (pos + 1) & mask;
+				table[pos] = e;
+			}
+		}
+	};
+
+	shard m_shards[1 << shard_bits];
+};
+
+// takes memory from an arena when given one, from the heap otherwise.
+// copies of a container never inherit the arena, so they can outlive it
+template <typename T> class arena_allocator
+{
+public:
+
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap            = std::true_type;
+
+	arena_allocator(arena* a = nullptr) noexcept : m_arena(a) {}
+	template <typename U> arena_allocator(arena_allocator<U> const& other) noexcept : m_arena(other.m_arena) {}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(m_arena ? m_arena->allocate(n * sizeof(T), alignof(T)) : ::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, std::size_t) noexcept
+	{
+		if (!m_arena) ::operator delete(p);
+	}
+
+	arena_allocator select_on_container_copy_construction() const { return arena_allocator(); }
+
+	template <typename U> bool operator == (arena_allocator<U> const& other) const { return m_arena == other.m_arena; }
+	template <typename U> bool operator != (arena_allocator<U> const& other) const { return m_arena != other.m_arena; }
+
+private:
+
+	template <typename U> friend class arena_allocator;
+	arena* m_arena;
+};
+
 inline char const* type_string(type t)
 {
 	switch (t)
@@ -53,6 +402,7 @@ inline char const* type_string(type t)
 		case type::n_double: return "double";
 		case type::n_int32:  return "int32";
 		case type::n_int64:  return "int64";
+		case type::n_uint64: return "uint64";
 		case type::string:   return "string";
 		case type::binary:   return "binary";
 		case type::array:    return "array";
@@ -61,21 +411,46 @@ inline char const* type_string(type t)
 	}
 }
 
+class value;
+
+// reports a document as a sequence of events, see sax_handler below
+template <typename Handler> bool sax_parse(char const* str, Handler& handler, std::string* errors = nullptr);
+template <typename Handler> class push_parser;
+
 class value
 {
 friend void run_tests();
+friend class document;
+template <typename Handler> friend bool sax_parse(char const* str, Handler& handler, std::string* errors);
+template <typename Handler> friend class push_parser;
+friend class path;
+friend class cursor;
+friend class bson_view;
+friend class bson_stream;
 public:
 
 	using pair_t   = std::pair<std::string, value>;
-	using object_t = std::vector<pair_t>;
-	using array_t  = std::vector<value>;
+	using object_t = std::vector<pair_t, arena_allocator<pair_t>>;
+	using array_t  = std::vector<value, arena_allocator<value>>;
 	
-	bool from_string(char const* str, std::string* errors = nullptr)
+	bool from_string(char const* str, std::string* errors = nullptr, parse_options const& options = parse_options::global())
 	{
-		json_reader r;
+		json_reader r(nullptr, options);
 		return r.parse_string(str, *this, errors);
 	}
 
+	// str[len] must still be the terminating zero; knowing the length saves a pass over the text
+	bool from_string(char const* str, std::size_t len, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		json_reader r(nullptr, options);
+		return r.parse_string(str, *this, errors, str + len + 1);
+	}
+
+	bool from_string(std::string const& str, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_string(str.c_str(), str.size(), errors, options);
+	}
+
 	char const* to_string(serialize_options const& options = serialize_options::global()) const
 	{
 		thread_local strbuf_t buf;
@@ -84,50 +459,176 @@ public:
 		return buf.data();
 	}
 	
-	bool from_json_file(char const* filename, std::string* errors = nullptr)
+	bool from_json_file(char const* filename, std::string* errors = nullptr, parse_options const& options = parse_options::global())
 	{
-		json_reader r;
+		json_reader r(nullptr, options);
 		return r.parse_file(filename, *this, errors);
 	};
 
 	bool to_json_file(char const* filename, serialize_options const& options = serialize_options::global()) const
 	{
-		std::ofstream ofs(filename);
-		if (ofs)
+		std::FILE* file = std::fopen(filename, "w");
+		if (file)
 		{
-			ofs << to_string(options);
-			return true;
+			bool ok = write_json(file, options);
+			return std::fclose(file) == 0 && ok;
 		}
 		else
 		{
 			return false;
 		}
-		return false;
 	}
 
-	bool from_bytes(char const* data, size_t size, std::string* errors = nullptr)
+	// MARK: streaming output
+	// Serializes through a fixed buffer that is flushed as it fills, so the text is never held in
+	// memory as a whole. Returns false if a write failed.
+	bool write_json(write_sink sink, void* context, serialize_options const& options = serialize_options::global()) const
+	{
+		strbuf_t buf;
+		buf.set_sink(sink, context, 65536);
+		json_writer w(buf);
+		return w.stream(*this, options);
+	}
+
+	bool write_json(std::ostream& os, serialize_options const& options = serialize_options::global()) const
+	{
+		return write_json([](void* context, char const* data, std::size_t size)
+		{
+			return !static_cast<std::ostream*>(context)->write(data, size).fail();
+		}, &os, options);
+	}
+
+	bool write_json(std::FILE* file, serialize_options const& options = serialize_options::global()) const
+	{
+		return write_json([](void* context, char const* data, std::size_t size)
+		{
+			return std::fwrite(data, 1, size, static_cast<std::FILE*>(context)) == size;
+		}, file, options);
+	}
+
+#if JAYSON_POSIX
+	bool write_json(int fd, serialize_options const& options = serialize_options::global()) const
+	{
+		return write_json([](void* context, char const* data, std::size_t size)
+		{
+			int fd = *static_cast<int*>(context);
+			while (size)
+			{
+				ssize_t written = ::write(fd, data, size);
+				if (written < 0 && errno == EINTR) continue;
+				if (written <= 0) return false;
+				data += written;
+				size -= static_cast<std::size_t>(written);
+			}
+			return true;
+		}, &fd, options);
+	}
+#endif
+
+	bool from_bytes(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
 	{
-		bson_reader r;
+		bson_reader r(nullptr, options);
 		return r.parse_data(data, size, *this, errors);
 	}
 
-	bool from_bytes(bytes_t const& data, std::string* errors = nullptr)
+	bool from_bytes(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
 	{
-		bson_reader r;
+		bson_reader r(nullptr, options);
 		return r.parse_data(data, *this, errors);
 	}
 	
 	bytes_t to_bytes() const
 	{
-		thread_local bson_writer w;
-		w.clear();
-		w.write_value(nullptr, *this);
-		return w.data;
+		bytes_t data(bson_writer::size(*this));
+		bson_writer::write(*this, data.data());
+		return data;
+	}
+
+	// exact length of to_bytes(), throws unless this is an object
+	std::size_t bson_size() const
+	{
+		return bson_writer::size(*this);
+	}
+
+	// encodes into memory the caller owns, returns the length written or 0 if it doesn't fit
+	std::size_t to_bytes(char* buffer, std::size_t capacity) const
+	{
+		std::size_t size = bson_writer::size(*this);
+		if (size > capacity) return 0;
+		bson_writer::write(*this, buffer);
+		return size;
+	}
+
+	// MessagePack and CBOR encode any value, not only objects, and keep the integer and double types apart
+	bool from_msgpack(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		msgpack_reader r(nullptr, options);
+		return r.parse_data(data, size, *this, errors);
+	}
+
+	bool from_msgpack(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_msgpack(data.data(), data.size(), errors, options);
+	}
+
+	bytes_t to_msgpack() const
+	{
+		bytes_t data(msgpack_writer::size(*this));
+		msgpack_writer::write(*this, data.data());
+		return data;
+	}
+
+	// exact length of to_msgpack()
+	std::size_t msgpack_size() const
+	{
+		return msgpack_writer::size(*this);
+	}
+
+	// returns the length written, or 0 if it doesn't fit
+	std::size_t to_msgpack(char* buffer, std::size_t capacity) const
+	{
+		std::size_t size = msgpack_writer::size(*this);
+		if (size > capacity) return 0;
+		msgpack_writer::write(*this, buffer);
+		return size;
+	}
+
+	bool from_cbor(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		cbor_reader r(nullptr, options);
+		return r.parse_data(data, size, *this, errors);
+	}
+
+	bool from_cbor(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_cbor(data.data(), data.size(), errors, options);
+	}
+
+	bytes_t to_cbor() const
+	{
+		bytes_t data(cbor_writer::size(*this));
+		cbor_writer::write(*this, data.data());
+		return data;
+	}
+
+	// exact length of to_cbor()
+	std::size_t cbor_size() const
+	{
+		return cbor_writer::size(*this);
 	}
 
-	bool from_bson_file(char const* filename, std::string* errors = nullptr)
+	// returns the length written, or 0 if it doesn't fit
+	std::size_t to_cbor(char* buffer, std::size_t capacity) const
 	{
-		bson_reader r;
+		std::size_t size = cbor_writer::size(*this);
+		if (size > capacity) return 0;
+		cbor_writer::write(*this, buffer);
+		return size;
+	}
+
+	bool from_bson_file(char const* filename, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		bson_reader r(nullptr, options);
 		return r.parse_file(filename, *this, errors);
 	}
 
@@ -152,146 +653,398 @@ private:
 	using ilist_t  = std::initializer_list<value>;
 	using string_t = std::string;
 	
+	// MARK: object index
+	// Pairs stay in insertion order. Small objects are searched by scanning the pairs; past
+	// index_threshold keys a flat Robin Hood table maps key hashes to their positions, and
+	// every hit is confirmed by comparing the full key.
 	class obj_impl_t
 	{
 	public:
+
+		obj_impl_t(arena* a = nullptr) : obj(a), slots(a) {}
 		
 		bool empty() const { return obj.empty(); }
 		std::size_t size() const { return obj.size(); }
 		object_t const& object() const { return obj; }
 		
-		bool has_key(std::string const& key) const
+		// K is a string_ref, hashed only once the index exists, or a key with its hash precomputed
+		template <typename K> bool has_key(K const& k) const
 		{
-			return map.find(hash(key)) != map.end();
+			return index_of(k) != npos;
 		}
 		
-		void remove(std::string const& key)
+		// the pairs after the removed one move down, so this is linear in the size of the object
+		template <typename K> void remove(K const& k)
 		{
-			auto it = map.find(hash(key));
-			if (it != map.end())
+			if (slots.empty())
 			{
-				std::size_t index = it->second;
-				for (auto& pair : map)
+				std::size_t index = scan(k.data(), k.size());
+				if (index != npos) obj.erase(obj.begin() + index);
+				return;
+			}
+
+			std::size_t pos = find(k.data(), k.size(), hash(k));
+			if (pos != npos)
+			{
+				uint32_t index = slots[pos].index;
+				erase_slot(pos);
+				obj.erase(obj.begin() + index);
+				for (auto& s : slots)
 				{
-					if (pair.second > index) --pair.second;
+					if (s.index != empty_slot && s.index > index) --s.index;
 				}
-				
-				obj.erase(obj.begin() + index);
-				map.erase(it);
 			}
 		}
 
-		value const& get_const(std::string const& key) const
+		template <typename K> value const& get_const(K const& k) const
+		{
+			std::size_t index = index_of(k);
+			return index != npos ? obj[index].second : value::null();
+		}
+
+		// nullptr if missing, where get_const can't tell a missing key from a null value
+		template <typename K> value const* lookup(K const& k) const
+		{
+			std::size_t index = index_of(k);
+			return index != npos ? &obj[index].second : nullptr;
+		}
+
+		// room for n pairs, and for their index when there will be one
+		void reserve(std::size_t n)
 		{
-			auto it = map.find(hash(key));
-			return it != map.end() ? obj[it->second].second : value::null();
+			obj.reserve(n);
+			if (n > index_threshold)
+			{
+				std::size_t capacity = 16;
+				while (n * 4 > capacity * 3) capacity *= 2;
+				if (capacity > slots.size()) rehash(capacity);
+			}
 		}
 
-		value& get(std::string const& key)
+		template <typename K> value& get(K const& k)
 		{
-			auto h = hash(key);
-			auto it = map.find(h);
-			if (it != map.end())
+			if (slots.empty())
+			{
+				std::size_t index = scan(k.data(), k.size());
+				if (index != npos) return obj[index].second;
+				if (obj.size() < index_threshold)
+				{
+					obj.emplace_back(std::piecewise_construct, std::forward_as_tuple(k.data(), k.size()), std::forward_as_tuple());
+					return obj.back().second;
+				}
+				rehash(16);
+			}
+
+			uint32_t h = hash(k);
+			std::size_t pos = find(k.data(), k.size(), h);
+			if (pos != npos)
 			{
-				return obj[it->second].second;
+				return obj[slots[pos].index].second;
 			}
 			else
 			{
-				map.emplace(h, obj.size());
-				obj.emplace_back(key, value());
+				if ((obj.size() + 1) * 4 > slots.size() * 3) rehash(slots.size() * 2);
+				place(slot{ static_cast<uint32_t>(obj.size()), h });
+				obj.emplace_back(std::piecewise_construct, std::forward_as_tuple(k.data(), k.size()), std::forward_as_tuple());
 				return obj.back().second;
 			}
 		}
 		
 	private:
-	
-		using map_t = std::unordered_map<size_t, size_t>; // hash -> index
-	
-		object_t  obj;
-		map_t     map;
-		
-		static std::size_t hash(std::string const& key) { return std::hash<std::string>{}(key); }
-	};
 
-	union
-	{
-		bool        b;
-		double      d;
-		int32_t     i;
-		int64_t     l;
-		uint64_t    u;
-		string_t*   s;
-		array_t*    a;
-		obj_impl_t* o;
-		bytes_t*    x;
-	} data;
-	
-	type type;
+		struct slot
+		{
+			uint32_t index; // position in obj, empty_slot if unused
+			uint32_t hash;
+		};
 
-public:
-	
-	static value const& null() { static value val; return val; }
+		using slots_t = std::vector<slot, arena_allocator<slot>>;
+
+		static constexpr uint32_t    empty_slot      = UINT32_MAX;
+		static constexpr std::size_t npos            = SIZE_MAX;
+		static constexpr std::size_t index_threshold = 8;
 	
-	~value()
-	{
-		switch (type)
+		object_t obj;
+		slots_t  slots; // empty below index_threshold keys, otherwise a power of two at most three quarters full
+
+		template <typename K> std::size_t index_of(K const& k) const
 		{
-			case type::string: delete data.s; break;
-			case type::array:  delete data.a; break;
-			case type::object: delete data.o; break;
-			case type::binary: delete data.x; break;
-			default:;
+			if (slots.empty()) return scan(k.data(), k.size());
+			std::size_t pos = find(k.data(), k.size(), hash(k));
+			return pos != npos ? slots[pos].index : npos;
 		}
-	}
-
-	// MARK: constructors
-	value()                     : value(type::null)     {}
-	value(value const& v)       : value(type::null)     { *this = v; }
-	value(value&& v) noexcept   : value(type::null)     { std::swap(type, v.type); std::swap(data, v.data); }
-	value(char const* v)        : value(type::string)   { *data.s = v ? v : ""; }
-	value(std::string const& v) : value(type::string)   { *data.s = v; }
-	value(bytes_t const& v)     : value(type::binary)   { *data.x = v; }
-	value(ilist_t const& list)  : value(type::array)    { *data.a = list; }
-	value(ilist_t&& list)       : value(type::array)    { *data.a = list; }
+
+		std::size_t scan(char const* key, std::size_t len) const
+		{
+			for (std::size_t i=0; i<obj.size(); ++i)
+			{
+				std::string const& k = obj[i].first;
+				if (k.size() == len && memcmp(k.data(), key, len) == 0) return i;
+			}
+			return npos;
+		}
+
+		static uint32_t hash(json::key const& k)  { return k.hash; }
+		static uint32_t hash(string_ref const& k) { return key_hash(k.data(), k.size()); }
+
+		// how far a slot is from where its hash wants it
+		std::size_t distance(slot const& s, std::size_t pos) const { return (pos - s.hash) & (slots.size() - 1); }
+
+		std::size_t find(char const* key, std::size_t len, uint32_t h) const
+		{
+			if (slots.empty()) return npos;
+			std::size_t mask = slots.size() - 1;
+			for (std::size_t pos = h & mask, dist = 0;; pos = (pos + 1) & mask, ++dist)
+			{
+				slot const& s = slots[pos];
+				if (s.index == empty_slot || distance(s, pos) < dist) return npos; // the key would have displaced this one
+				if (s.hash == h)
+				{
+					std::string const& k = obj[s.index].first;
+					if (k.size() == len && memcmp(k.data(), key, len) == 0) return pos;
+				}
+			}
+		}
+
+		// entries closer to their home give way to the one being placed
+		void place(slot s)
+		{
+			std::size_t mask = slots.size() - 1;
+			for (std::size_t pos = s.hash & mask, dist = 0;; pos = (pos + 1) & mask, ++dist)
+			{
+				slot& cur = slots[pos];
+				if (cur.index == empty_slot)
+				{
+					cur = s;
+					return;
+				}
+				std::size_t d = distance(cur, pos);
+				if (d < dist)
+				{
+					std::swap(cur, s);
+					dist = d;
+				}
+			}
+		}
+
+		// shifts the following cluster back instead of leaving a tombstone
+		void erase_slot(std::size_t pos)
+		{
+			std::size_t mask = slots.size() - 1;
+			for (std::size_t next = (pos + 1) & mask; slots[next].index != empty_slot && distance(slots[next], next) > 0; next = (next + 1) & mask)
+			{
+				slots[pos] = slots[next];
+				pos = next;
+			}
+			slots[pos].index = empty_slot;
+		}
+
+		// the first call indexes the pairs collected so far, later ones reuse the stored hashes
+		void rehash(std::size_t capacity)
+		{
+			slots_t old(capacity, slot{ empty_slot, 0 }, slots.get_allocator());
+			old.swap(slots);
+			if (old.empty())
+			{
+				for (std::size_t i=0; i<obj.size(); ++i)
+				{
+					place(slot{ static_cast<uint32_t>(i), key_hash(obj[i].first.data(), obj[i].first.size()) });
+				}
+			}
+			for (auto const& s : old)
+			{
+				if (s.index != empty_slot) place(s);
+			}
+		}
+	};
+
+	enum class storage : uint8_t
+	{
+		heap,     // payload is owned and deleted by the value
+		external, // payload belongs to an arena; strings are zero terminated and not owned at all
+		view      // string points into the parsed text and is not zero terminated
+	};
+
+	type     type;
+	uint8_t  m_short;   // short string length + 1, 0 when the string lives elsewhere
+	storage  m_storage; // meaningful only when m_short is 0
+	uint32_t m_length;  // length of a string that is not owned
+
+	// short strings are stored inline in the bytes that follow m_short
+	static constexpr std::size_t short_capacity = 14;
+
+	union
+	{
+		bool        b;
+		double      d;
+		int32_t     i;
+		int64_t     l;
+		uint64_t    u;
+		string_t*   s;
+		char const* p;
+		array_t*    a;
+		obj_impl_t* o;
+		bytes_t*    x;
+	} data;
+
+	char*       short_data()       { return reinterpret_cast<char*>(this) + 2; }
+	char const* short_data() const { return reinterpret_cast<char const*>(this) + 2; }
+
+	bool heap_string() const { return !m_short && m_storage == storage::heap; }
+
+	char const* str_data() const { return m_short ? short_data() : heap_string() ? data.s->c_str() : data.p; }
+	std::size_t str_size() const { return m_short ? m_short - 1 : heap_string() ? data.s->size() : m_length; }
+
+	bool str_borrowed() const { return !m_short && m_storage == storage::view; }
+
+	// zero terminated string, a view into the parsed text is copied first
+	char const* str_terminated()
+	{
+		if (str_borrowed()) set_string(data.p, m_length);
+		return str_data();
+	}
+
+	void set_string(char const* str, std::size_t len)
+	{
+		if (len < short_capacity)
+		{
+			string_t* heap = heap_string() ? data.s : nullptr; // str may point into it
+			memmove(short_data(), str, len);
+			short_data()[len] = '\0';
+			m_short = static_cast<uint8_t>(len + 1);
+			delete heap;
+		}
+		else if (heap_string())
+		{
+			data.s->assign(str, len);
+		}
+		else
+		{
+			data.s = new string_t(str, len);
+			m_short = 0;
+			m_storage = storage::heap;
+		}
+	}
+
+	void set_external(char const* str, std::size_t len, storage mode = storage::external)
+	{
+		if (heap_string()) delete data.s;
+		data.p = str;
+		m_length = static_cast<uint32_t>(len);
+		m_short = 0;
+		m_storage = mode;
+	}
+
+	void move_to_heap()
+	{
+		if (!heap_string())
+		{
+			string_t* heap = new string_t(str_data(), str_size());
+			data.s = heap;
+			m_short = 0;
+			m_storage = storage::heap;
+		}
+	}
+
+	template <typename T> void destroy(T* payload)
+	{
+		if (m_storage == storage::heap) delete payload;
+		else payload->~T();
+	}
+
+	void swap_storage(value& v) noexcept
+	{
+		char tmp[sizeof(value)];
+		memcpy(tmp, static_cast<void*>(this), sizeof(value));
+		memcpy(static_cast<void*>(this), static_cast<void*>(&v), sizeof(value));
+		memcpy(static_cast<void*>(&v), tmp, sizeof(value));
+	}
+
+public:
+	
+	static value const& null() { static value val; return val; }
+	
+	~value()
+	{
+		switch (type)
+		{
+			case type::string: if (heap_string()) delete data.s; break;
+			case type::array:  destroy(data.a); break;
+			case type::object: destroy(data.o); break;
+			case type::binary: delete data.x; break;
+			default:;
+		}
+	}
+
+	// MARK: constructors
+	value()                     : value(type::null)     {}
+	value(value const& v)       : value(type::null)     { *this = v; }
+	value(value&& v) noexcept   : value(type::null)     { swap_storage(v); }
+	value(char const* v)        : value(type::string)   { if (v) set_string(v, strlen(v)); }
+	value(std::string const& v) : value(type::string)   { set_string(v.data(), v.size()); }
+	value(string_ref const& v)  : value(type::string)   { set_string(v.data(), v.size()); }
+	value(bytes_t const& v)     : value(type::binary)   { *data.x = v; }
+	value(ilist_t const& list)  : value(type::array)    { *data.a = list; }
+	value(ilist_t&& list)       : value(type::array)    { *data.a = list; }
 
 	template <typename T, typename std::enable_if<std::is_same<T, bool>::value, bool>::type = true>                                                               value(T v) : value(type::boolean)  { data.b = v; } // bool
 	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) < sizeof(int32_t) && !std::is_same<T, bool>::value, bool>::type = true> value(T v) : value(type::n_int32)  { data.l = v; } // ints less than sizeof(int32) -> int32, set all bits
-	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int32_t), bool>::type = true>                                 value(T v) : value(type::n_int32)  { data.l = v; } // int32, set all bits
-	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int64_t), bool>::type = true>                                 value(T v) : value(type::n_int64)  { data.l = v; } // int64
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int32_t) && std::is_signed<T>::value, bool>::type = true>     value(T v) : value(type::n_int32)  { data.l = v; } // int32, set all bits
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int32_t) && std::is_unsigned<T>::value, bool>::type = true>   value(T v) : value(v > INT32_MAX ? type::n_int64 : type::n_int32) { data.l = v; } // uint32, int64 above INT32_MAX
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int64_t) && std::is_signed<T>::value, bool>::type = true>     value(T v) : value(type::n_int64)  { data.l = v; } // int64
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == sizeof(int64_t) && std::is_unsigned<T>::value, bool>::type = true>   value(T v) : value(v > INT64_MAX ? type::n_uint64 : type::n_int64) { data.u = v; } // uint64, only above INT64_MAX
 	template <typename T, typename std::enable_if<std::is_floating_point<T>::value && sizeof(T) <= sizeof(double), bool>::type = true>                            value(T v) : value(type::n_double) { data.d = v; } // float/double
 
-	value(enum type t) : type(t)
+	value(enum type t) : value(t, nullptr) {}
+
+	// containers taken from an arena must not outlive it
+	value(enum type t, arena* a) : type(t), m_short(0), m_storage(a ? storage::external : storage::heap)
 	{
 		switch (type)
 		{
-			case type::string: data.s = new string_t(); break;
-			case type::array:  data.a = new array_t();  break;
-			case type::object: data.o = new obj_impl_t(); break;
-			case type::binary: data.x = new bytes_t();  break;
+			case type::string: m_short = 1; short_data()[0] = '\0'; break;
+			case type::array:  data.a = a ? a->create<array_t>(a) : new array_t(); break;
+			case type::object: data.o = a ? a->create<obj_impl_t>(a) : new obj_impl_t(); break;
+			case type::binary: data.x = new bytes_t(); m_storage = storage::heap; break;
 			default:;
 		}
 	}
 
+	value(string_ref const& v, arena* a) : value(type::string)
+	{
+		if (a && v.size() >= short_capacity && v.size() <= UINT32_MAX) set_external(a->copy(v.data(), v.size()), v.size());
+		else set_string(v.data(), v.size());
+	}
+
+	// refers to the pool's copy, which must outlive the value
+	value(string_ref const& v, string_pool& pool) : value(type::string)
+	{
+		if (v.size() >= short_capacity && v.size() <= UINT32_MAX) set_external(pool.intern(v).data(), v.size());
+		else set_string(v.data(), v.size());
+	}
+
 	// MARK: assignment operators
 	value& operator = (value const& v)
 	{
+		if (this == &v) return *this;
 		check_type(v.type);
 		switch (type)
 		{
 			case type::boolean : data.b  =  v.data.b; break;
-			case type::string  : *data.s = *v.data.s; break;
+			case type::string  : set_string(v.str_data(), v.str_size()); break;
 			case type::array   : *data.a = *v.data.a; break;
 			case type::object  : *data.o = *v.data.o; break;
 			case type::binary  : *data.x = *v.data.x; break;
 			case type::n_double: data.d  =  v.data.d; break;
 			case type::n_int32 : data.i  =  v.data.i; break;
 			case type::n_int64 : data.l  =  v.data.l; break;
+			case type::n_uint64: data.u  =  v.data.u; break;
 			case type::null:;
 		}
 		return *this;
 	}
 	
-	value& operator = (value&& v) { std::swap(type, v.type); std::swap(data, v.data); return *this; }
+	value& operator = (value&& v) { swap_storage(v); return *this; }
 	
 	enum type get_type() const { return type; }
 	
@@ -299,10 +1052,11 @@ public:
 	bool is(enum type atype) const { return type == atype;  }
 	bool is_null()   const { return type == type::null;     }
 	bool is_bool()   const { return type == type::boolean;  }
-	bool is_number() const { return type == type::n_double || type == type::n_int32 || type == type::n_int64;  }
+	bool is_number() const { return type == type::n_double || type == type::n_int32 || type == type::n_int64 || type == type::n_uint64; }
 	bool is_double() const { return type == type::n_double; }
 	bool is_int32()  const { return type == type::n_int32;  }
 	bool is_int64()  const { return type == type::n_int64;  }
+	bool is_uint64() const { return type == type::n_uint64; }
 	bool is_string() const { return type == type::string;   }
 	bool is_array()  const { return type == type::array;    }
 	bool is_object() const { return type == type::object;   }
@@ -317,10 +1071,15 @@ public:
 		case type::n_double: return data.d;
 		case type::n_int32:  return data.i;
 		case type::n_int64:  return data.l;
+		case type::n_uint64: return data.u;
 		default: return 0;
 		}
 	}
 
+	// the same conversions, except as<std::string const&>() and as<char const*>() which may change
+	// how the string is stored
+	template <typename T> T as() { return static_cast<value const*>(this)->as<T>(); }
+
 	std::size_t size() const
 	{
 		if      (type == type::array)  return data.a->size();
@@ -369,16 +1128,21 @@ public:
 		return type == type::object ? data.o->object() : empty;
 	}
 	
-	bool has_key(std::string const& key) const
-	{
-		return type == type::object ? data.o->has_key(key) : false;
-	}
+	// json::key lookups use the precomputed hash, string lookups hash only in indexed objects
+	bool has_key(json::key const& k)   const { return type == type::object ? data.o->has_key(k) : false; }
+	bool has_key(std::string const& k) const { return type == type::object ? data.o->has_key(string_ref(k.data(), k.size())) : false; }
+	bool has_key(char const* k)        const { return type == type::object ? data.o->has_key(string_ref(k, strlen(k))) : false; }
 	
-	value const& operator () (std::string const& key) const { return type == type::object ? data.o->get_const(key) : null(); }
-	value&       operator () (std::string const& key)       { check_type(type::object); return data.o->get(key); }
+	value const& operator () (json::key const& k)   const { return type == type::object ? data.o->get_const(k) : null(); }
+	value const& operator () (std::string const& k) const { return type == type::object ? data.o->get_const(string_ref(k.data(), k.size())) : null(); }
+	value const& operator () (char const* k)        const { return type == type::object ? data.o->get_const(string_ref(k, strlen(k))) : null(); }
+	value&       operator () (json::key const& k)         { check_type(type::object); return data.o->get(k); }
+	value&       operator () (std::string const& k)       { check_type(type::object); return data.o->get(string_ref(k.data(), k.size())); }
+	value&       operator () (char const* k)              { check_type(type::object); return data.o->get(string_ref(k, strlen(k))); }
 	
-	void remove_key(char const* key) { if (type == type::object) data.o->remove(key); }
-	void remove_key(std::string const& key) { remove_key(key.c_str()); }
+	void remove_key(json::key const& k)   { if (type == type::object) data.o->remove(k); }
+	void remove_key(std::string const& k) { if (type == type::object) data.o->remove(string_ref(k.data(), k.size())); }
+	void remove_key(char const* k)        { if (type == type::object) data.o->remove(string_ref(k, strlen(k))); }
 	
 private:
 	
@@ -398,9 +1162,26 @@ private:
 		~strbuf_t() { std::free(head); }
 
 		void clear() { m_size = 0; }
+		size_t size() const { return m_size; }
 		size_t capacity() const { return m_capacity; }
 		char const* data() const { return head; }
 
+		// with a sink the buffer keeps its size and hands over its contents whenever it fills up
+		void set_sink(write_sink sink, void* context, size_t size)
+		{
+			m_sink = sink;
+			m_context = context;
+			reserve(size);
+		}
+
+		// false once the sink has failed, later output is dropped
+		bool flush()
+		{
+			if (m_sink && m_size && m_sink_ok) m_sink_ok = m_sink(m_context, head, m_size);
+			m_size = 0;
+			return m_sink_ok;
+		}
+
 		strbuf_t& operator << (char c)
 		{
 			resize(m_size + 1);
@@ -419,6 +1200,11 @@ private:
 		
 		void write(char const* str, size_t len)
 		{
+			if (m_sink && len >= m_capacity)
+			{
+				if (flush()) m_sink_ok = m_sink(m_context, str, len); // too big to go through the buffer
+				return;
+			}
 			resize(m_size + len);
 			memcpy(&head[m_size], str, len);
 			m_size += len;
@@ -431,13 +1217,21 @@ private:
 
 	private:
 
-		char*  head = nullptr;
-		size_t m_capacity = 0;
-		size_t m_size = 0;
+		char*      head = nullptr;
+		size_t     m_capacity = 0;
+		size_t     m_size = 0;
+		write_sink m_sink = nullptr;
+		void*      m_context = nullptr;
+		bool       m_sink_ok = true;
 		
 		void resize(size_t size)
 		{
 			if (size < m_capacity) return;
+			if (m_sink && size - m_size < m_capacity)
+			{
+				flush();
+				return;
+			}
 			if (m_capacity == 0) m_capacity = 4096;
 			else while (size >= m_capacity) m_capacity *= 2;
 			head = (char*)realloc(head, m_capacity);
@@ -446,1021 +1240,4632 @@ private:
 	
 #pragma mark -
 
-	// MARK: json parser
-	class json_reader
+	// MARK: block scanning
+	// Classifies 16 bytes per step instead of testing one byte at a time. A block is loaded
+	// only when it ends at or before limit, the end of memory known to be readable; the
+	// bytes after the last whole block are tested one at a time.
+	struct scanner
 	{
-	public:
-	
-		bool parse_file(char const* filename, value& result, std::string* errors)
-		{
-			std::ifstream file(filename);
-			if (file)
-			{
-				std::stringstream ss;
-				ss << file.rdbuf();
-				return parse_string(ss.str().data(), result, errors);
-			}
-			else
-			{
-				if (errors) *errors = "failed to load file '" + std::string(filename) + "'";
-				return false;
-			}
-		}
-		
-		bool parse_string(char const* string, value& result, std::string* errors)
+		static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+		// returns first byte that is not a whitespace, counting skipped newlines
+		static char const* skip_spaces(char const* p, char const* limit, std::size_t& lines)
 		{
-			line_num = 1;
-			if (string)
+#if JAYSON_SSE2
+			for (; limit - p >= 16; p += 16)
 			{
-				source = string;
-				try
-				{
-					read_value(result);
-					return true;
-				}
-				catch (std::exception const &ex)
+				__m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+				__m128i nl    = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+				__m128i ws    = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), nl));
+				uint32_t other    = ~static_cast<uint32_t>(_mm_movemask_epi8(ws)) & 0xffffu;
+				uint32_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(nl));
+				if (other)
 				{
-					if (errors)
-					{
-						std::ostringstream oss;
-						oss << ex.what() << " at line " << line_num;
-						*errors = oss.str();
-					}
-					return false;
+					lines += popcount(newlines & ((other & (0 - other)) - 1));
+					return p + ctz(other);
 				}
+				lines += popcount(newlines);
 			}
-			else
+#else
+			(void)limit;
+#endif
+			while (is_space(*p))
 			{
-				if (errors) *errors = "no data";
-				result = value();
-				return false;
+				if (*p == '\n') ++lines;
+				++p;
 			}
+			return p;
 		}
-		
-	private:
-		
-		char const* source;
-		std::size_t line_num;
-		strbuf_t    strbuf;
-		
-		void skip_whitespaces()
+
+		// returns first '"', '\\' or terminating zero
+		static char const* find_string_special(char const* p, char const* limit)
 		{
-			while (*source)
+#if JAYSON_SSE2
+			for (; limit - p >= 16; p += 16)
 			{
-				if (*source == '\n') ++line_num;
-				if (*source != ' ' && *source != '\t' && *source != '\r' && *source != '\n') return;
-				else ++source;
+				__m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+				__m128i hits  = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+					_mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+				if (mask) return p + ctz(mask);
 			}
-			throw fail("unexpected end of document");
+#else
+			(void)limit;
+#endif
+			while (*p != '\\' && *p != '"' && *p != '\0') ++p;
+			return p;
 		}
-		
-		void read_value(value& val)
+
+		// reads 8 digits at once into acc, fails if any byte is not a digit or the load would pass limit
+		static bool eight_digits(char const* p, char const* limit, uint64_t& acc)
 		{
-			skip_whitespaces();
-			switch (*source)
-			{
-				case '[': read_array (val); break;
-				case '{': read_object(val); break;
-				case '"': val = read_string(); break;
-				case 'n': skip_check("null");  val = value(); break;
-				case 't': skip_check("true");  val = true;    break;
-				case 'f': skip_check("false"); val = false;   break;
-				default:  read_number(val); break;
-			}
+#if JAYSON_SWAR
+			if (limit - p < 8) return false;
+			uint64_t chunk;
+			memcpy(&chunk, p, 8);
+			if (((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) != 0x3333333333333333) return false;
+			chunk -= 0x3030303030303030;
+			chunk = chunk * 10 + (chunk >> 8);                                 // pairs
+			chunk = (((chunk & 0x000000FF000000FF) * 0x000F424000000064) +     // quads, then all eight
+			         (((chunk >> 16) & 0x000000FF000000FF) * 0x0000271000000001)) >> 32;
+			acc = acc * 100000000 + static_cast<uint32_t>(chunk);
+			return true;
+#else
+			(void)p; (void)limit; (void)acc;
+			return false;
+#endif
 		}
-		
-		void skip_check(char const* str)
+
+		// returns first byte in [p, end) that the writer must escape: '"', '\\', control characters,
+		// and with escape_utf8 everything above 0x7f. Loads are unaligned and stay inside the range.
+		static char const* find_escape(char const* p, char const* end, bool escape_utf8)
 		{
-			for (char const* p = str; *p; ++p)
+#if JAYSON_SSE2
+			__m128i const quote     = _mm_set1_epi8('"');
+			__m128i const backslash = _mm_set1_epi8('\\');
+			__m128i const del       = _mm_set1_epi8(0x7f);
+			__m128i const space     = _mm_set1_epi8(0x20);
+			__m128i const control   = _mm_set1_epi8(0x1f);
+			for (; end - p >= 16; p += 16)
 			{
-				if (*source++ != *p)
-				{
-					std::string err = "expected ";
-					err += str;
-					throw fail(err.c_str());
-				}
+				__m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+				__m128i low   = escape_utf8
+					? _mm_cmplt_epi8(chunk, space)                              // signed: also catches 0x80 and up
+					: _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk);
+				__m128i hits  = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, del), low));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+				if (mask) return p + ctz(mask);
+			}
+#endif
+			for (; p != end; ++p)
+			{
+				uint8_t c = static_cast<uint8_t>(*p);
+				if (c < 0x20 || c == '"' || c == '\\' || c == 0x7f || (escape_utf8 && c > 0x7f)) return p;
 			}
+			return p;
 		}
-		
-		void read_object(value& val)
+
+		static bool valid_utf8(char const* begin, char const* end)
 		{
-			++source;
-			val = value(type::object);
-			while (*source)
+			uint8_t const* p = reinterpret_cast<uint8_t const*>(begin);
+			uint8_t const* e = reinterpret_cast<uint8_t const*>(end);
+			while (p != e)
 			{
-				skip_whitespaces();
-				
-				if (*source == '}')
-				{
-					++source;
-					return;
-				}
-				
-				if (*source == '"')
+#if JAYSON_SSE2
+				if (e - p >= 16)
 				{
-					char const* key = read_string();
-					skip_whitespaces();
-					if (*source++ == ':')
-					{
-						skip_whitespaces();
-						read_value(val(key));
-						skip_whitespaces();
-						if      (*source == ',') ++source;
-						else if (*source == '}') { ++source; return; }
-						else throw fail("missing comma in object");
-					}
-					else
+					uint32_t high = static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))));
+					if (!high)
 					{
-						throw fail("expected ':' after pair key");
+						p += 16;
+						continue;
 					}
+					p += ctz(high);
 				}
-				else
+#endif
+				uint8_t c = *p;
+				if (c < 0x80)
 				{
-					throw fail("expected quoted pair key");
+					++p;
+					continue;
 				}
-			}
-			throw fail("unexpected end of object");
-		}
 
-		void read_array(value& val)
-		{
-			++source;
-			val = value(type::array);
-			while (*source)
-			{
-				skip_whitespaces();
-				if (*source == ']')
+				// the second byte has a narrower range where overlong forms, surrogates or values above U+10FFFF start
+				std::ptrdiff_t tail;
+				uint8_t lo = 0x80, hi = 0xbf;
+				if      (c >= 0xc2 && c <= 0xdf) tail = 1;
+				else if (c >= 0xe0 && c <= 0xef) { tail = 2; if (c == 0xe0) lo = 0xa0; else if (c == 0xed) hi = 0x9f; }
+				else if (c >= 0xf0 && c <= 0xf4) { tail = 3; if (c == 0xf0) lo = 0x90; else if (c == 0xf4) hi = 0x8f; }
+				else return false;
+
+				if (e - p <= tail || p[1] < lo || p[1] > hi) return false;
+				for (std::ptrdiff_t i=2; i<=tail; ++i)
 				{
-					++source;
-					return;
+					if ((p[i] & 0xc0) != 0x80) return false;
 				}
-				
-				val.data.a->emplace_back();
-				read_value(val.data.a->back());
-				skip_whitespaces();
-				if      (*source == ',') ++source;
-				else if (*source == ']') { ++source; return; }
-				else throw fail("missing comma in array");
+				p += tail + 1;
 			}
-			throw fail("unexpected end of array");
+			return true;
 		}
-		
-		void read_number(value& val)
+
+		static unsigned ctz(uint32_t mask)
 		{
-			bool is_float = false;
-			double sign = 1.0;
-			char c = *source;
-			if      (c == '-')             { sign = -1.0; ++source; }
-			else if (c == '+')             { ++source; }
-			else if (c >= '0' && c <= '9') { }
-			else throw fail("invalid numeric value");
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+		}
 
-			int shift = 0;
-			double result = 0;
-			while (*source >= '0' && *source <= '9')
-			{
-				result = result * 10.0 + (*source++ - '0');
-			}
+		static std::size_t popcount(uint32_t mask)
+		{
+			std::size_t n = 0;
+			for (; mask; mask &= mask - 1) ++n;
+			return n;
+		}
+	};
 
-			if (*source == '.')
+#pragma mark -
+
+	// MARK: decimal to double
+	// Eisel-Lemire: w * 10^q is rounded correctly from a 128-bit approximation of 5^q,
+	// which is always precise enough for up to 19 significant digits
+	struct float_parser
+	{
+		static double convert(uint64_t w, int64_t q, bool negative)
+		{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+			// Clinger: w and 10^q are exact doubles, so one operation rounds correctly
+			if (w <= (uint64_t(1) << 53) && q >= -22 && q <= 22)
 			{
-				is_float = true;
-				++source;
-				while (*source >= '0' && *source <= '9')
+				static double const exact[] =
 				{
-					result = result * 10.0 + (*source++ - '0');
-					--shift;
-				}
+					1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+					1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+				};
+				double d = static_cast<double>(w);
+				d = q < 0 ? d / exact[-q] : d * exact[q];
+				return negative ? -d : d;
 			}
+#endif
+			if (w == 0 || q < -342) return assemble(0, 0, negative);
+			if (q > 308) return assemble(0, 0x7ff, negative);
 
-			if (*source == 'e' || *source == 'E')
+			int lz = clz(w);
+			w <<= lz;
+
+			uint64_t const* power = powers_of_five() + 2 * (q + 342);
+			uint64_t lo;
+			uint64_t hi = multiply(w, power[0], lo);
+			if ((hi & 0x1ff) == 0x1ff) // the truncated low bits could carry into the mantissa
 			{
-				is_float = true;
-				++source;
-				int exp_sign = 1;
-				if      (*source == '-') { ++source; exp_sign = -1; }
-				else if (*source == '+') { ++source; }
-				
-				int exponent = 0;
-				while (*source >= '0' && *source <= '9')
-				{
-					exponent = exponent * 10 + (*source++ - '0');
-				}
-				
-				shift += exponent * exp_sign;
+				uint64_t lo2;
+				uint64_t hi2 = multiply(w, power[1], lo2);
+				lo += hi2;
+				if (hi2 > lo) ++hi;
 			}
-			
-			if      (shift < 0) while (shift++ != 0) result *= 0.1;
-			else if (shift > 0) while (shift-- != 0) result *= 10.0;
-			
-			if (is_float)
+
+			int upperbit = static_cast<int>(hi >> 63);
+			int shift = upperbit + 64 - 52 - 3;
+			uint64_t mantissa = hi >> shift;
+			int32_t power2 = static_cast<int32_t>((((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023);
+
+			if (power2 <= 0) // subnormal
 			{
-				val = result * sign;
+				if (-power2 + 1 >= 64) return assemble(0, 0, negative);
+				mantissa >>= -power2 + 1;
+				mantissa += mantissa & 1;
+				mantissa >>= 1;
+				// rounding up may have made it normal again
+				return assemble(mantissa, mantissa < (uint64_t(1) << 52) ? 0 : 1, negative);
 			}
-			else
+
+			// exactly halfway between two doubles: round to even instead of up
+			if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
 			{
-				if (result < 0x7FFFFFFF)
-				{
-					val = static_cast<int>(result * sign);
-				}
-				else
-				{
-					if (sign < 0)
-					{
-						val = static_cast<int64_t>(result * sign);
-					}
-					else
-					{
-						val = static_cast<uint64_t>(result);
-					}
-				}
+				mantissa &= ~uint64_t(1);
+			}
+
+			mantissa += mantissa & 1;
+			mantissa >>= 1;
+			if (mantissa >= (uint64_t(2) << 52))
+			{
+				mantissa = uint64_t(1) << 52;
+				++power2;
 			}
+			mantissa &= ~(uint64_t(1) << 52);
+			if (power2 >= 0x7ff) return assemble(0, 0x7ff, negative);
+			return assemble(mantissa, power2, negative);
 		}
-		
-		void read_unicode_symbol(strbuf_t& sb)
+
+	private:
+
+		static double assemble(uint64_t mantissa, int32_t power2, bool negative)
 		{
-			auto read_word = [&]()
+			uint64_t bits = mantissa | (static_cast<uint64_t>(power2) << 52) | (static_cast<uint64_t>(negative) << 63);
+			double d;
+			memcpy(&d, &bits, sizeof(d));
+			return d;
+		}
+
+		static uint64_t multiply(uint64_t a, uint64_t b, uint64_t& lo)
+		{
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+			lo = static_cast<uint64_t>(r);
+			return static_cast<uint64_t>(r >> 64);
+#else
+			uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+			uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+			uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+			uint64_t mid = (p0 >> 32) + (p1 & 0xffffffff) + (p2 & 0xffffffff);
+			lo = (mid << 32) | (p0 & 0xffffffff);
+			return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+		}
+
+		static int clz(uint64_t w)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, w);
+			return 63 - static_cast<int>(index);
+#elif defined(_MSC_VER)
+			int n = 0;
+			while (!(w & (uint64_t(1) << 63))) { w <<= 1; ++n; }
+			return n;
+#else
+			return __builtin_clzll(w);
+#endif
+		}
+
+		// 128-bit truncated 5^q for q in [-342, 308], normalized to the top bit
+		static uint64_t const* powers_of_five()
+		{
+			static uint64_t const table[] =
 			{
-				uint16_t code = 0;
-				for (int i=0; i<4; ++i)
-				{
-					uint16_t sym = source[i+1];
-					if (!sym) throw fail("unexpected end of unicode symbol");
-					if      (sym >= '0' && sym <= '9') sym -= 48;
-					else if (sym >= 'a' && sym <= 'f') sym -= 87;
-					else if (sym >= 'A' && sym <= 'F') sym -= 55;
-					else throw fail("invalid hex value");
-					code = (code << 4) | sym;
-				}
-				source += 4;
-				return code;
+				0xeef453d6923bd65a, 0x113faa2906a13b3f, 0x9558b4661b6565f8, 0x4ac7ca59a424c507,
+				0xbaaee17fa23ebf76, 0x5d79bcf00d2df649, 0xe95a99df8ace6f53, 0xf4d82c2c107973dc,
+				0x91d8a02bb6c10594, 0x79071b9b8a4be869, 0xb64ec836a47146f9, 0x9748e2826cdee284,
+				0xe3e27a444d8d98b7, 0xfd1b1b2308169b25, 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7,
+				0xb208ef855c969f4f, 0xbdbd2d335e51a935, 0xde8b2b66b3bc4723, 0xad2c788035e61382,
+				0x8b16fb203055ac76, 0x4c3bcb5021afcc31, 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d,
+				0xd953e8624b85dd78, 0xd71d6dad34a2af0d, 0x87d4713d6f33aa6b, 0x8672648c40e5ad68,
+				0xa9c98d8ccb009506, 0x680efdaf511f18c2, 0xd43bf0effdc0ba48, 0x0212bd1b2566def2,
+				0x84a57695fe98746d, 0x014bb630f7604b57, 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d,
+				0xcf42894a5dce35ea, 0x52064cac828675b9, 0x818995ce7aa0e1b2, 0x7343efebd1940993,
+				0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8, 0xca66fa129f9b60a6, 0xd41a26e077774ef6,
+				0xfd00b897478238d0, 0x8920b098955522b4, 0x9e20735e8cb16382, 0x55b46e5f5d5535b0,
+				0xc5a890362fddbc62, 0xeb2189f734aa831d, 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4,
+				0x9a6bb0aa55653b2d, 0x47b233c92125366e, 0xc1069cd4eabe89f8, 0x999ec0bb696e840a,
+				0xf148440a256e2c76, 0xc00670ea43ca250d, 0x96cd2a865764dbca, 0x380406926a5e5728,
+				0xbc807527ed3e12bc, 0xc605083704f5ecf2, 0xeba09271e88d976b, 0xf7864a44c633682e,
+				0x93445b8731587ea3, 0x7ab3ee6afbe0211d, 0xb8157268fdae9e4c, 0x5960ea05bad82964,
+				0xe61acf033d1a45df, 0x6fb92487298e33bd, 0x8fd0c16206306bab, 0xa5d3b6d479f8e056,
+				0xb3c4f1ba87bc8696, 0x8f48a4899877186c, 0xe0b62e2929aba83c, 0x331acdabfe94de87,
+				0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14, 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9,
+				0xdb71e91432b1a24a, 0xc9e82cd9f69d6150, 0x892731ac9faf056e, 0xbe311c083a225cd2,
+				0xab70fe17c79ac6ca, 0x6dbd630a48aaf406, 0xd64d3d9db981787d, 0x092cbbccdad5b108,
+				0x85f0468293f0eb4e, 0x25bbf56008c58ea5, 0xa76c582338ed2621, 0xaf2af2b80af6f24e,
+				0xd1476e2c07286faa, 0x1af5af660db4aee1, 0x82cca4db847945ca, 0x50d98d9fc890ed4d,
+				0xa37fce126597973c, 0xe50ff107bab528a0, 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8,
+				0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a, 0x9faacf3df73609b1, 0x77b191618c54e9ac,
+				0xc795830d75038c1d, 0xd59df5b9ef6a2417, 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d,
+				0x9becce62836ac577, 0x4ee367f9430aec32, 0xc2e801fb244576d5, 0x229c41f793cda73f,
+				0xf3a20279ed56d48a, 0x6b43527578c1110f, 0x9845418c345644d6, 0x830a13896b78aaa9,
+				0xbe5691ef416bd60c, 0x23cc986bc656d553, 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8,
+				0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9, 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53,
+				0xe858ad248f5c22c9, 0xd1b3400f8f9cff68, 0x91376c36d99995be, 0x23100809b9c21fa1,
+				0xb58547448ffffb2d, 0xabd40a0c2832a78a, 0xe2e69915b3fff9f9, 0x16c90c8f323f516c,
+				0x8dd01fad907ffc3b, 0xae3da7d97f6792e3, 0xb1442798f49ffb4a, 0x99cd11cfdf41779c,
+				0xdd95317f31c7fa1d, 0x40405643d711d583, 0x8a7d3eef7f1cfc52, 0x482835ea666b2572,
+				0xad1c8eab5ee43b66, 0xda3243650005eecf, 0xd863b256369d4a40, 0x90bed43e40076a82,
+				0x873e4f75e2224e68, 0x5a7744a6e804a291, 0xa90de3535aaae202, 0x711515d0a205cb36,
+				0xd3515c2831559a83, 0x0d5a5b44ca873e03, 0x8412d9991ed58091, 0xe858790afe9486c2,
+				0xa5178fff668ae0b6, 0x626e974dbe39a872, 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f,
+				0x80fa687f881c7f8e, 0x7ce66634bc9d0b99, 0xa139029f6a239f72, 0x1c1fffc1ebc44e80,
+				0xc987434744ac874e, 0xa327ffb266b56220, 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8,
+				0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9, 0xc4ce17b399107c22, 0xcb550fb4384d21d3,
+				0xf6019da07f549b2b, 0x7e2a53a146606a48, 0x99c102844f94e0fb, 0x2eda7444cbfc426d,
+				0xc0314325637a1939, 0xfa911155fefb5308, 0xf03d93eebc589f88, 0x793555ab7eba27ca,
+				0x96267c7535b763b5, 0x4bc1558b2f3458de, 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16,
+				0xea9c227723ee8bcb, 0x465e15a979c1cadc, 0x92a1958a7675175f, 0x0bfacd89ec191ec9,
+				0xb749faed14125d36, 0xcef980ec671f667b, 0xe51c79a85916f484, 0x82b7e12780e7401a,
+				0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810, 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15,
+				0xdfbdcece67006ac9, 0x67a791e093e1d49a, 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0,
+				0xaecc49914078536d, 0x58fae9f773886e18, 0xda7f5bf590966848, 0xaf39a475506a899e,
+				0x888f99797a5e012d, 0x6d8406c952429603, 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83,
+				0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64, 0x855c3be0a17fcd26, 0x5cf2eea09a55067f,
+				0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e, 0xd0601d8efc57b08b, 0xf13b94daf124da26,
+				0x823c12795db6ce57, 0x76c53d08d6b70858, 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e,
+				0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09, 0xfe5d54150b090b02, 0xd3f93b35435d7c4c,
+				0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf, 0xc6b8e9b0709f109a, 0x359ab6419ca1091b,
+				0xf867241c8cc6d4c0, 0xc30163d203c94b62, 0x9b407691d7fc44f8, 0x79e0de63425dcf1d,
+				0xc21094364dfb5636, 0x985915fc12f542e4, 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d,
+				0x979cf3ca6cec5b5a, 0xa705992ceecf9c42, 0xbd8430bd08277231, 0x50c6ff782a838353,
+				0xece53cec4a314ebd, 0xa4f8bf5635246428, 0x940f4613ae5ed136, 0x871b7795e136be99,
+				0xb913179899f68584, 0x28e2557b59846e3f, 0xe757dd7ec07426e5, 0x331aeada2fe589cf,
+				0x9096ea6f3848984f, 0x3ff0d2c85def7621, 0xb4bca50b065abe63, 0x0fed077a756b53a9,
+				0xe1ebce4dc7f16dfb, 0xd3e8495912c62894, 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c,
+				0xb080392cc4349dec, 0xbd8d794d96aacfb3, 0xdca04777f541c567, 0xecf0d7a0fc5583a0,
+				0x89e42caaf9491b60, 0xf41686c49db57244, 0xac5d37d5b79b6239, 0x311c2875c522ced5,
+				0xd77485cb25823ac7, 0x7d633293366b828b, 0x86a8d39ef77164bc, 0xae5dff9c02033197,
+				0xa8530886b54dbdeb, 0xd9f57f830283fdfc, 0xd267caa862a12d66, 0xd072df63c324fd7b,
+				0x8380dea93da4bc60, 0x4247cb9e59f71e6d, 0xa46116538d0deb78, 0x52d9be85f074e608,
+				0xcd795be870516656, 0x67902e276c921f8b, 0x806bd9714632dff6, 0x00ba1cd8a3db53b6,
+				0xa086cfcd97bf97f3, 0x80e8a40eccd228a4, 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd,
+				0xfad2a4b13d1b5d6c, 0x796b805720085f81, 0x9cc3a6eec6311a63, 0xcbe3303674053bb0,
+				0xc3f490aa77bd60fc, 0xbedbfc4411068a9c, 0xf4f1b4d515acb93b, 0xee92fb5515482d44,
+				0x991711052d8bf3c5, 0x751bdd152d4d1c4a, 0xbf5cd54678eef0b6, 0xd262d45a78a0635d,
+				0xef340a98172aace4, 0x86fb897116c87c34, 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0,
+				0xbae0a846d2195712, 0x8974836059cca109, 0xe998d258869facd7, 0x2bd1a438703fc94b,
+				0x91ff83775423cc06, 0x7b6306a34627ddcf, 0xb67f6455292cbf08, 0x1a3bc84c17b1d542,
+				0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93, 0x8e938662882af53e, 0x547eb47b7282ee9c,
+				0xb23867fb2a35b28d, 0xe99e619a4f23aa43, 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4,
+				0x8b3c113c38f9f37e, 0xde83bc408dd3dd04, 0xae0b158b4738705e, 0x9624ab50b148d445,
+				0xd98ddaee19068c76, 0x3badd624dd9b0957, 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6,
+				0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c, 0xd47487cc8470652b, 0x7647c3200069671f,
+				0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073, 0xa5fb0a17c777cf09, 0xf468107100525890,
+				0xcf79cc9db955c2cc, 0x7182148d4066eeb4, 0x81ac1fe293d599bf, 0xc6f14cd848405530,
+				0xa21727db38cb002f, 0xb8ada00e5a506a7c, 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c,
+				0xfd442e4688bd304a, 0x908f4a166d1da663, 0x9e4a9cec15763e2e, 0x9a598e4e043287fe,
+				0xc5dd44271ad3cdba, 0x40eff1e1853f29fd, 0xf7549530e188c128, 0xd12bee59e68ef47c,
+				0x9a94dd3e8cf578b9, 0x82bb74f8301958ce, 0xc13a148e3032d6e7, 0xe36a52363c1faf01,
+				0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1, 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9,
+				0xbcb2b812db11a5de, 0x7415d448f6b6f0e7, 0xebdf661791d60f56, 0x111b495b3464ad21,
+				0x936b9fcebb25c995, 0xcab10dd900beec34, 0xb84687c269ef3bfb, 0x3d5d514f40eea742,
+				0xe65829b3046b0afa, 0x0cb4a5a3112a5112, 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab,
+				0xb3f4e093db73a093, 0x59ed216765690f56, 0xe0f218b8d25088b8, 0x306869c13ec3532c,
+				0x8c974f7383725573, 0x1e414218c73a13fb, 0xafbd2350644eeacf, 0xe5d1929ef90898fa,
+				0xdbac6c247d62a583, 0xdf45f746b74abf39, 0x894bc396ce5da772, 0x6b8bba8c328eb783,
+				0xab9eb47c81f5114f, 0x066ea92f3f326564, 0xd686619ba27255a2, 0xc80a537b0efefebd,
+				0x8613fd0145877585, 0xbd06742ce95f5f36, 0xa798fc4196e952e7, 0x2c48113823b73704,
+				0xd17f3b51fca3a7a0, 0xf75a15862ca504c5, 0x82ef85133de648c4, 0x9a984d73dbe722fb,
+				0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba, 0xcc963fee10b7d1b3, 0x318df905079926a8,
+				0xffbbcfe994e5c61f, 0xfdf17746497f7052, 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633,
+				0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0, 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0,
+				0x9c1661a651213e2d, 0x06bea10ca65c084e, 0xc31bfa0fe5698db8, 0x486e494fcff30a62,
+				0xf3e2f893dec3f126, 0x5a89dba3c3efccfa, 0x986ddb5c6b3a76b7, 0xf89629465a75e01c,
+				0xbe89523386091465, 0xf6bbb397f1135823, 0xee2ba6c0678b597f, 0x746aa07ded582e2c,
+				0x94db483840b717ef, 0xa8c2a44eb4571cdc, 0xba121a4650e4ddeb, 0x92f34d62616ce413,
+				0xe896a0d7e51e1566, 0x77b020baf9c81d17, 0x915e2486ef32cd60, 0x0ace1474dc1d122e,
+				0xb5b5ada8aaff80b8, 0x0d819992132456ba, 0xe3231912d5bf60e6, 0x10e1fff697ed6c69,
+				0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1, 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2,
+				0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde, 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b,
+				0xad4ab7112eb3929d, 0x86c16c98d2c953c6, 0xd89d64d57a607744, 0xe871c7bf077ba8b7,
+				0x87625f056c7c4a8b, 0x11471cd764ad4972, 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf,
+				0xd389b47879823479, 0x4aff1d108d4ec2c3, 0x843610cb4bf160cb, 0xcedf722a585139ba,
+				0xa54394fe1eedb8fe, 0xc2974eb4ee658828, 0xce947a3da6a9273e, 0x733d226229feea32,
+				0x811ccc668829b887, 0x0806357d5a3f525f, 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7,
+				0xc9bcff6034c13052, 0xfc89b393dd02f0b5, 0xfc2c3f3841f17c67, 0xbbac2078d443ace2,
+				0x9d9ba7832936edc0, 0xd54b944b84aa4c0d, 0xc5029163f384a931, 0x0a9e795e65d4df11,
+				0xf64335bcf065d37d, 0x4d4617b5ff4a16d5, 0x99ea0196163fa42e, 0x504bced1bf8e4e45,
+				0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6, 0xf07da27a82c37088, 0x5d767327bb4e5a4c,
+				0x964e858c91ba2655, 0x3a6a07f8d510f86f, 0xbbe226efb628afea, 0x890489f70a55368b,
+				0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e, 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d,
+				0xb77ada0617e3bbcb, 0x09ce6ebb40173744, 0xe55990879ddcaabd, 0xcc420a6a101d0515,
+				0x8f57fa54c2a9eab6, 0x9fa946824a12232d, 0xb32df8e9f3546564, 0x47939822dc96abf9,
+				0xdff9772470297ebd, 0x59787e2b93bc56f7, 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a,
+				0xaefae51477a06b03, 0xede622920b6b23f1, 0xdab99e59958885c4, 0xe95fab368e45eced,
+				0x88b402f7fd75539b, 0x11dbcb0218ebb414, 0xaae103b5fcd2a881, 0xd652bdc29f26a119,
+				0xd59944a37c0752a2, 0x4be76d3346f0495f, 0x857fcae62d8493a5, 0x6f70a4400c562ddb,
+				0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952, 0xd097ad07a71f26b2, 0x7e2000a41346a7a7,
+				0x825ecc24c873782f, 0x8ed400668c0c28c8, 0xa2f67f2dfa90563b, 0x728900802f0f32fa,
+				0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9, 0xfea126b7d78186bc, 0xe2f610c84987bfa8,
+				0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9, 0xc6ede63fa05d3143, 0x91503d1c79720dbb,
+				0xf8a95fcf88747d94, 0x75a44c6397ce912a, 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba,
+				0xc24452da229b021b, 0xfbe85badce996168, 0xf2d56790ab41c2a2, 0xfae27299423fb9c3,
+				0x97c560ba6b0919a5, 0xdccd879fc967d41a, 0xbdb6b8e905cb600f, 0x5400e987bbc1c920,
+				0xed246723473e3813, 0x290123e9aab23b68, 0x9436c0760c86e30b, 0xf9a0b6720aaf6521,
+				0xb94470938fa89bce, 0xf808e40e8d5b3e69, 0xe7958cb87392c2c2, 0xb60b1d1230b20e04,
+				0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2, 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3,
+				0xe2280b6c20dd5232, 0x25c6da63c38de1b0, 0x8d590723948a535f, 0x579c487e5a38ad0e,
+				0xb0af48ec79ace837, 0x2d835a9df0c6d851, 0xdcdb1b2798182244, 0xf8e431456cf88e65,
+				0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff, 0xac8b2d36eed2dac5, 0xe272467e3d222f3f,
+				0xd7adf884aa879177, 0x5b0ed81dcc6abb0f, 0x86ccbb52ea94baea, 0x98e947129fc2b4e9,
+				0xa87fea27a539e9a5, 0x3f2398d747b36224, 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad,
+				0x83a3eeeef9153e89, 0x1953cf68300424ac, 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7,
+				0xcdb02555653131b6, 0x3792f412cb06794d, 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0,
+				0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4, 0xc8de047564d20a8b, 0xf245825a5a445275,
+				0xfb158592be068d2e, 0xeed6e2f0f0d56712, 0x9ced737bb6c4183d, 0x55464dd69685606b,
+				0xc428d05aa4751e4c, 0xaa97e14c3c26b886, 0xf53304714d9265df, 0xd53dd99f4b3066a8,
+				0x993fe2c6d07b7fab, 0xe546a8038efe4029, 0xbf8fdb78849a5f96, 0xde98520472bdd033,
+				0xef73d256a5c0f77c, 0x963e66858f6d4440, 0x95a8637627989aad, 0xdde7001379a44aa8,
+				0xbb127c53b17ec159, 0x5560c018580d5d52, 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6,
+				0x9226712162ab070d, 0xcab3961304ca70e8, 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22,
+				0xe45c10c42a2b3b05, 0x8cb89a7db77c506a, 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242,
+				0xb267ed1940f1c61c, 0x55f038b237591ed3, 0xdf01e85f912e37a3, 0x6b6c46dec52f6688,
+				0x8b61313bbabce2c6, 0x2323ac4b3b3da015, 0xae397d8aa96c1b77, 0xabec975e0a0d081a,
+				0xd9c7dced53c72255, 0x96e7bd358c904a21, 0x881cea14545c7575, 0x7e50d64177da2e54,
+				0xaa242499697392d2, 0xdde50bd1d5d0b9e9, 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864,
+				0x84ec3c97da624ab4, 0xbd5af13bef0b113e, 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e,
+				0xcfb11ead453994ba, 0x67de18eda5814af2, 0x81ceb32c4b43fcf4, 0x80eacf948770ced7,
+				0xa2425ff75e14fc31, 0xa1258379a94d028d, 0xcad2f7f5359a3b3e, 0x096ee45813a04330,
+				0xfd87b5f28300ca0d, 0x8bca9d6e188853fc, 0x9e74d1b791e07e48, 0x775ea264cf55347e,
+				0xc612062576589dda, 0x95364afe032a819e, 0xf79687aed3eec551, 0x3a83ddbd83f52205,
+				0x9abe14cd44753b52, 0xc4926a9672793543, 0xc16d9a0095928a27, 0x75b7053c0f178294,
+				0xf1c90080baf72cb1, 0x5324c68b12dd6339, 0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+				0xbce5086492111aea, 0x88f4bb1ca6bcf585, 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+				0x9392ee8e921d5d07, 0x3aff322e62439fd0, 0xb877aa3236a4b449, 0x09befeb9fad487c3,
+				0xe69594bec44de15b, 0x4c2ebe687989a9b4, 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+				0xb424dc35095cd80f, 0x538484c19ef38c95, 0xe12e13424bb40e13, 0x2865a5f206b06fba,
+				0x8cbccc096f5088cb, 0xf93f87b7442e45d4, 0xafebff0bcb24aafe, 0xf78f69a51539d749,
+				0xdbe6fecebdedd5be, 0xb573440e5a884d1c, 0x89705f4136b4a597, 0x31680a88f8953031,
+				0xabcc77118461cefc, 0xfdc20d2b36ba7c3e, 0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+				0x8637bd05af6c69b5, 0xa63f9a49c2c1b110, 0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+				0xd1b71758e219652b, 0xd3c36113404ea4a9, 0x83126e978d4fdf3b, 0x645a1cac083126ea,
+				0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4, 0xcccccccccccccccc, 0xcccccccccccccccd,
+				0x8000000000000000, 0x0000000000000000, 0xa000000000000000, 0x0000000000000000,
+				0xc800000000000000, 0x0000000000000000, 0xfa00000000000000, 0x0000000000000000,
+				0x9c40000000000000, 0x0000000000000000, 0xc350000000000000, 0x0000000000000000,
+				0xf424000000000000, 0x0000000000000000, 0x9896800000000000, 0x0000000000000000,
+				0xbebc200000000000, 0x0000000000000000, 0xee6b280000000000, 0x0000000000000000,
+				0x9502f90000000000, 0x0000000000000000, 0xba43b74000000000, 0x0000000000000000,
+				0xe8d4a51000000000, 0x0000000000000000, 0x9184e72a00000000, 0x0000000000000000,
+				0xb5e620f480000000, 0x0000000000000000, 0xe35fa931a0000000, 0x0000000000000000,
+				0x8e1bc9bf04000000, 0x0000000000000000, 0xb1a2bc2ec5000000, 0x0000000000000000,
+				0xde0b6b3a76400000, 0x0000000000000000, 0x8ac7230489e80000, 0x0000000000000000,
+				0xad78ebc5ac620000, 0x0000000000000000, 0xd8d726b7177a8000, 0x0000000000000000,
+				0x878678326eac9000, 0x0000000000000000, 0xa968163f0a57b400, 0x0000000000000000,
+				0xd3c21bcecceda100, 0x0000000000000000, 0x84595161401484a0, 0x0000000000000000,
+				0xa56fa5b99019a5c8, 0x0000000000000000, 0xcecb8f27f4200f3a, 0x0000000000000000,
+				0x813f3978f8940984, 0x4000000000000000, 0xa18f07d736b90be5, 0x5000000000000000,
+				0xc9f2c9cd04674ede, 0xa400000000000000, 0xfc6f7c4045812296, 0x4d00000000000000,
+				0x9dc5ada82b70b59d, 0xf020000000000000, 0xc5371912364ce305, 0x6c28000000000000,
+				0xf684df56c3e01bc6, 0xc732000000000000, 0x9a130b963a6c115c, 0x3c7f400000000000,
+				0xc097ce7bc90715b3, 0x4b9f100000000000, 0xf0bdc21abb48db20, 0x1e86d40000000000,
+				0x96769950b50d88f4, 0x1314448000000000, 0xbc143fa4e250eb31, 0x17d955a000000000,
+				0xeb194f8e1ae525fd, 0x5dcfab0800000000, 0x92efd1b8d0cf37be, 0x5aa1cae500000000,
+				0xb7abc627050305ad, 0xf14a3d9e40000000, 0xe596b7b0c643c719, 0x6d9ccd05d0000000,
+				0x8f7e32ce7bea5c6f, 0xe4820023a2000000, 0xb35dbf821ae4f38b, 0xdda2802c8a800000,
+				0xe0352f62a19e306e, 0xd50b2037ad200000, 0x8c213d9da502de45, 0x4526f422cc340000,
+				0xaf298d050e4395d6, 0x9670b12b7f410000, 0xdaf3f04651d47b4c, 0x3c0cdd765f114000,
+				0x88d8762bf324cd0f, 0xa5880a69fb6ac800, 0xab0e93b6efee0053, 0x8eea0d047a457a00,
+				0xd5d238a4abe98068, 0x72a4904598d6d880, 0x85a36366eb71f041, 0x47a6da2b7f864750,
+				0xa70c3c40a64e6c51, 0x999090b65f67d924, 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d,
+				0x82818f1281ed449f, 0xbff8f10e7a8921a4, 0xa321f2d7226895c7, 0xaff72d52192b6a0d,
+				0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490, 0xfee50b7025c36a08, 0x02f236d04753d5b4,
+				0x9f4f2726179a2245, 0x01d762422c946590, 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5,
+				0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2, 0x9b934c3b330c8577, 0x63cc55f49f88eb2f,
+				0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb, 0xf316271c7fc3908a, 0x8bef464e3945ef7a,
+				0x97edd871cfda3a56, 0x97758bf0e3cbb5ac, 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317,
+				0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd, 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a,
+				0xb975d6b6ee39e436, 0xb3e2fd538e122b44, 0xe7d34c64a9c85d44, 0x60dbbca87196b616,
+				0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd, 0xb51d13aea4a488dd, 0x6babab6398bdbe41,
+				0xe264589a4dcdab14, 0xc696963c7eed2dd1, 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2,
+				0xb0de65388cc8ada8, 0x3b25a55f43294bcb, 0xdd15fe86affad912, 0x49ef0eb713f39ebe,
+				0x8a2dbf142dfcc7ab, 0x6e3569326c784337, 0xacb92ed9397bf996, 0x49c2c37f07965404,
+				0xd7e77a8f87daf7fb, 0xdc33745ec97be906, 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3,
+				0xa8acd7c0222311bc, 0xc40832ea0d68ce0c, 0xd2d80db02aabd62b, 0xf50a3fa490c30190,
+				0x83c7088e1aab65db, 0x792667c6da79e0fa, 0xa4b8cab1a1563f52, 0x577001b891185938,
+				0xcde6fd5e09abcf26, 0xed4c0226b55e6f86, 0x80b05e5ac60b6178, 0x544f8158315b05b4,
+				0xa0dc75f1778e39d6, 0x696361ae3db1c721, 0xc913936dd571c84c, 0x03bc3a19cd1e38e9,
+				0xfb5878494ace3a5f, 0x04ab48a04065c723, 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76,
+				0xc45d1df942711d9a, 0x3ba5d0bd324f8394, 0xf5746577930d6500, 0xca8f44ec7ee36479,
+				0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb, 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e,
+				0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e, 0x95d04aee3b80ece5, 0xbba1f1d158724a12,
+				0xbb445da9ca61281f, 0x2a8a6e45ae8edc97, 0xea1575143cf97226, 0xf52d09d71a3293bd,
+				0x924d692ca61be758, 0x593c2626705f9c56, 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c,
+				0xe498f455c38b997a, 0x0b6dfb9c0f956447, 0x8edf98b59a373fec, 0x4724bd4189bd5eac,
+				0xb2977ee300c50fe7, 0x58edec91ec2cb657, 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed,
+				0x8b865b215899f46c, 0xbd79e0d20082ee74, 0xae67f1e9aec07187, 0xecd8590680a3aa11,
+				0xda01ee641a708de9, 0xe80e6f4820cc9495, 0x884134fe908658b2, 0x3109058d147fdcdd,
+				0xaa51823e34a7eede, 0xbd4b46f0599fd415, 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a,
+				0x850fadc09923329e, 0x03e2cf6bc604ddb0, 0xa6539930bf6bff45, 0x84db8346b786151c,
+				0xcfe87f7cef46ff16, 0xe612641865679a63, 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e,
+				0xa26da3999aef7749, 0xe3be5e330f38f09d, 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5,
+				0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6, 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa,
+				0xc646d63501a1511d, 0xb281e1fd541501b8, 0xf7d88bc24209a565, 0x1f225a7ca91a4226,
+				0x9ae757596946075f, 0x3375788de9b06958, 0xc1a12d2fc3978937, 0x0052d6b1641c83ae,
+				0xf209787bb47d6b84, 0xc0678c5dbd23a49a, 0x9745eb4d50ce6332, 0xf840b7ba963646e0,
+				0xbd176620a501fbff, 0xb650e5a93bc3d898, 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe,
+				0x93ba47c980e98cdf, 0xc66f336c36b10137, 0xb8a8d9bbe123f017, 0xb80b0047445d4184,
+				0xe6d3102ad96cec1d, 0xa60dc059157491e5, 0x9043ea1ac7e41392, 0x87c89837ad68db2f,
+				0xb454e4a179dd1877, 0x29babe4598c311fb, 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a,
+				0x8ce2529e2734bb1d, 0x1899e4a65f58660c, 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f,
+				0xdc21a1171d42645d, 0x76707543f4fa1f73, 0x899504ae72497eba, 0x6a06494a791c53a8,
+				0xabfa45da0edbde69, 0x0487db9d17636892, 0xd6f8d7509292d603, 0x45a9d2845d3c42b6,
+				0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2, 0xa7f26836f282b732, 0x8e6cac7768d7141e,
+				0xd1ef0244af2364ff, 0x3207d795430cd926, 0x8335616aed761f1f, 0x7f44e6bd49e807b8,
+				0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6, 0xcd036837130890a1, 0x36dba887c37a8c0f,
+				0x802221226be55a64, 0xc2494954da2c9789, 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c,
+				0xc83553c5c8965d3d, 0x6f92829494e5acc7, 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9,
+				0x9c69a97284b578d7, 0xff2a760414536efb, 0xc38413cf25e2d70d, 0xfef5138519684aba,
+				0xf46518c2ef5b8cd1, 0x7eb258665fc25d69, 0x98bf2f79d5993802, 0xef2f773ffbd97a61,
+				0xbeeefb584aff8603, 0xaafb550ffacfd8fa, 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38,
+				0x952ab45cfa97a0b2, 0xdd945a747bf26183, 0xba756174393d88df, 0x94f971119aeef9e4,
+				0xe912b9d1478ceb17, 0x7a37cd5601aab85d, 0x91abb422ccb812ee, 0xac62e055c10ab33a,
+				0xb616a12b7fe617aa, 0x577b986b314d6009, 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b,
+				0x8e41ade9fbebc27d, 0x14588f13be847307, 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8,
+				0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb, 0x8aec23d680043bee, 0x25de7bb9480d5854,
+				0xada72ccc20054ae9, 0xaf561aa79a10ae6a, 0xd910f7ff28069da4, 0x1b2ba1518094da04,
+				0x87aa9aff79042286, 0x90fb44d2f05d0842, 0xa99541bf57452b28, 0x353a1607ac744a53,
+				0xd3fa922f2d1675f2, 0x42889b8997915ce8, 0x847c9b5d7c2e09b7, 0x69956135febada11,
+				0xa59bc234db398c25, 0x43fab9837e699095, 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb,
+				0x8161afb94b44f57d, 0x1d1be0eebac278f5, 0xa1ba1ba79e1632dc, 0x6462d92a69731732,
+				0xca28a291859bbf93, 0x7d7b8f7503cfdcfe, 0xfcb2cb35e702af78, 0x5cda735244c3d43e,
+				0x9defbf01b061adab, 0x3a0888136afa64a7, 0xc56baec21c7a1916, 0x088aaa1845b8fdd0,
+				0xf6c69a72a3989f5b, 0x8aad549e57273d45, 0x9a3c2087a63f6399, 0x36ac54e2f678864b,
+				0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd, 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5,
+				0x969eb7c47859e743, 0x9f644ae5a4b1b325, 0xbc4665b596706114, 0x873d5d9f0dde1fee,
+				0xeb57ff22fc0c7959, 0xa90cb506d155a7ea, 0x9316ff75dd87cbd8, 0x09a7f12442d588f2,
+				0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f, 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa,
+				0x8fa475791a569d10, 0xf96e017d694487bc, 0xb38d92d760ec4455, 0x37c981dcc395a9ac,
+				0xe070f78d3927556a, 0x85bbe253f47b1417, 0x8c469ab843b89562, 0x93956d7478ccec8e,
+				0xaf58416654a6babb, 0x387ac8d1970027b2, 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e,
+				0x88fcf317f22241e2, 0x441fece3bdf81f03, 0xab3c2fddeeaad25a, 0xd527e81cad7626c3,
+				0xd60b3bd56a5586f1, 0x8a71e223d8d3b074, 0x85c7056562757456, 0xf6872d5667844e49,
+				0xa738c6bebb12d16c, 0xb428f8ac016561db, 0xd106f86e69d785c7, 0xe13336d701beba52,
+				0x82a45b450226b39c, 0xecc0024661173473, 0xa34d721642b06084, 0x27f002d7f95d0190,
+				0xcc20ce9bd35c78a5, 0x31ec038df7b441f4, 0xff290242c83396ce, 0x7e67047175a15271,
+				0x9f79a169bd203e41, 0x0f0062c6e984d386, 0xc75809c42c684dd1, 0x52c07b78a3e60868,
+				0xf92e0c3537826145, 0xa7709a56ccdf8a82, 0x9bbcc7a142b17ccb, 0x88a66076400bb691,
+				0xc2abf989935ddbfe, 0x6acff893d00ea435, 0xf356f7ebf83552fe, 0x0583f6b8c4124d43,
+				0x98165af37b2153de, 0xc3727a337a8b704a, 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c,
+				0xeda2ee1c7064130c, 0x1162def06f79df73, 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8,
+				0xb9a74a0637ce2ee1, 0x6d953e2bd7173692, 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437,
+				0x910ab1d4db9914a0, 0x1d9c9892400a22a2, 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b,
+				0xe2a0b5dc971f303a, 0x2e44ae64840fd61d, 0x8da471a9de737e24, 0x5ceaecfed289e5d2,
+				0xb10d8e1456105dad, 0x7425a83e872c5f47, 0xdd50f1996b947518, 0xd12f124e28f77719,
+				0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f, 0xace73cbfdc0bfb7b, 0x636cc64d1001550b,
+				0xd8210befd30efa5a, 0x3c47f7e05401aa4e, 0x8714a775e3e95c78, 0x65acfaec34810a71,
+				0xa8d9d1535ce3b396, 0x7f1839a741a14d0d, 0xd31045a8341ca07c, 0x1ede48111209a050,
+				0x83ea2b892091e44d, 0x934aed0aab460432, 0xa4e4b66b68b65d60, 0xf81da84d5617853f,
+				0xce1de40642e3f4b9, 0x36251260ab9d668e, 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019,
+				0xa1075a24e4421730, 0xb24cf65b8612f81f, 0xc94930ae1d529cfc, 0xdee033f26797b627,
+				0xfb9b7cd9a4a7443c, 0x169840ef017da3b1, 0x9d412e0806e88aa5, 0x8e1f289560ee864e,
+				0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2, 0xf5b5d7ec8acb58a2, 0xae10af696774b1db,
+				0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29, 0xbff610b0cc6edd3f, 0x17fd090a58d32af3,
+				0xeff394dcff8a948e, 0xddfc4b4cef07f5b0, 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e,
+				0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1, 0xea53df5fd18d5513, 0x84c86189216dc5ed,
+				0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4, 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1,
+				0xe4d5e82392a40515, 0x0fabaf3feaa5334a, 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e,
+				0xb2c71d5bca9023f8, 0x743e20e9ef511012, 0xdf78e4b2bd342cf6, 0x914da9246b255416,
+				0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e, 0xae9672aba3d0c320, 0xa184ac2473b529b1,
+				0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e, 0x8865899617fb1871, 0x7e2fa67c7a658892,
+				0xaa7eebfb9df9de8d, 0xddbb901b98feeab7, 0xd51ea6fa85785631, 0x552a74227f3ea565,
+				0x8533285c936b35de, 0xd53a88958f87275f, 0xa67ff273b8460356, 0x8a892abaf368f137,
+				0xd01fef10a657842c, 0x2d2b7569b0432d85, 0x8213f56a67f6b29b, 0x9c3b29620e29fc73,
+				0xa298f2c501f45f42, 0x8349f3ba91b47b8f, 0xcb3f2f7642717713, 0x241c70a936219a73,
+				0xfe0efb53d30dd4d7, 0xed238cd383aa0110, 0x9ec95d1463e8a506, 0xf4363804324a40aa,
+				0xc67bb4597ce2ce48, 0xb143c6053edcd0d5, 0xf81aa16fdc1b81da, 0xdd94b7868e94050a,
+				0x9b10a4e5e9913128, 0xca7cf2b4191c8326, 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0,
+				0xf24a01a73cf2dccf, 0xbc633b39673c8cec, 0x976e41088617ca01, 0xd5be0503e085d813,
+				0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18, 0xec9c459d51852ba2, 0xddf8e7d60ed1219e,
+				0x93e1ab8252f33b45, 0xcabb90e5c942b503, 0xb8da1662e7b00a17, 0x3d6a751f3b936243,
+				0xe7109bfba19c0c9d, 0x0cc512670a783ad4, 0x906a617d450187e2, 0x27fb2b80668b24c5,
+				0xb484f9dc9641e9da, 0xb1f9f660802dedf6, 0xe1a63853bbd26451, 0x5e7873f8a0396973,
+				0x8d07e33455637eb2, 0xdb0b487b6423e1e8, 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62,
+				0xdc5c5301c56b75f7, 0x7641a140cc7810fb, 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d,
+				0xac2820d9623bf429, 0x546345fa9fbdcd44, 0xd732290fbacaf133, 0xa97c177947ad4095,
+				0x867f59a9d4bed6c0, 0x49ed8eabcccc485d, 0xa81f301449ee8c70, 0x5c68f256bfff5a74,
+				0xd226fc195c6a2f8c, 0x73832eec6fff3111, 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab,
+				0xa42e74f3d032f525, 0xba3e7ca8b77f5e55, 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb,
+				0x80444b5e7aa7cf85, 0x7980d163cf5b81b3, 0xa0555e361951c366, 0xd7e105bcc332621f,
+				0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7, 0xfa856334878fc150, 0xb14f98f6f0feb951,
+				0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3, 0xc3b8358109e84f07, 0x0a862f80ec4700c8,
+				0xf4a642e14c6262c8, 0xcd27bb612758c0fa, 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c,
+				0xbf21e44003acdd2c, 0xe0470a63e6bd56c3, 0xeeea5d5004981478, 0x1858ccfce06cac74,
+				0x95527a5202df0ccb, 0x0f37801e0c43ebc8, 0xbaa718e68396cffd, 0xd30560258f54e6ba,
+				0xe950df20247c83fd, 0x47c6b82ef32a2069, 0x91d28b7416cdd27e, 0x4cdc331d57fa5441,
+				0xb6472e511c81471d, 0xe0133fe4adf8e952, 0xe3d8f9e563a198e5, 0x58180fddd97723a6,
+				0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648
 			};
-			
-			uint32_t code = 0;
-			uint16_t first = read_word();
-			if (first < 0xd800 || first > 0xdfff)
-			{
-				code = first;
-			}
-			else if (first >= 0xdc00)
-			{
-				throw fail("invalid unicode symbol");
-			}
-			else
+			return table;
+		}
+	};
+
+#pragma mark -
+
+	// MARK: json parser
+	// MARK: file input
+	// Read-only contents of a file followed by at least one zero byte, so the text parser can run
+	// over it directly. Regular files are mapped, with the tail padded by zero pages; anything
+	// else is read into memory.
+	class file_view
+	{
+	public:
+
+		explicit file_view(char const* filename)
+		{
+#if JAYSON_POSIX && !defined(JAYSON_NO_MMAP)
+			int fd = ::open(filename, O_RDONLY);
+			if (fd < 0) return;
+			struct stat st;
+			if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
 			{
-				if (source[1] != '\\' || source[2] != 'u') throw fail("invalid unicode symbol");
-				source += 2;
-			
-				uint16_t second = read_word();
-				code = (first & 0x3ff) << 10;
-				if (second < 0xdc00 || second > 0xdfff)
-				{
-					throw fail("invalid unicode symbol");
-				}
-				else
+				std::size_t size  = static_cast<std::size_t>(st.st_size);
+				std::size_t page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+				std::size_t total = (size / page + 1) * page;
+				void* base = ::mmap(nullptr, total, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+				if (base != MAP_FAILED)
 				{
-					code = code | (second & 0x3ff);
-					code += 0x10000;
+					if (size == 0 || ::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED)
+					{
+						if (size) ::madvise(base, size, MADV_SEQUENTIAL);
+						m_data   = static_cast<char const*>(base);
+						m_size   = size;
+						m_mapped = total;
+						m_open   = true;
+					}
+					else
+					{
+						::munmap(base, total);
+					}
 				}
 			}
-			
-			if (code < 0x80)
-			{
-				sb << static_cast<char>(code);
-			}
-			else if (code < 0x800)
+			::close(fd);
+			if (m_open) return;
+#endif
+			std::ifstream file(filename, std::ios::binary);
+			if (!file) return;
+			char chunk[65536];
+			while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0)
 			{
-				sb
-				<< static_cast<char>(((code >> 6) & 0x1f) | 0xc0)
-				<< static_cast<char>((code & 0x3f) | 0x80);
+				m_copy.insert(m_copy.end(), chunk, chunk + file.gcount());
 			}
-			else if (code < 0x8000)
+			m_size = m_copy.size();
+			m_copy.resize(m_size + 16, '\0'); // whole blocks can be read up to the terminating zero
+			m_data = m_copy.data();
+			m_open = true;
+		}
+
+		~file_view()
+		{
+#if JAYSON_POSIX && !defined(JAYSON_NO_MMAP)
+			if (m_mapped) ::munmap(const_cast<char*>(m_data), m_mapped);
+#endif
+		}
+
+		file_view(file_view const&) = delete;
+		file_view& operator = (file_view const&) = delete;
+
+		bool        is_open() const { return m_open; }
+		char const* data()    const { return m_data; }
+		std::size_t size()    const { return m_size; }
+
+		// the text is followed by zeros up to here, so it may be read in blocks
+		char const* limit()   const { return m_mapped ? m_data + m_mapped : m_data + m_copy.size(); }
+
+	private:
+
+		char const*       m_data   = "";
+		std::size_t       m_size   = 0;
+		std::size_t       m_mapped = 0;
+		std::vector<char> m_copy;
+		bool              m_open   = false;
+	};
+
+	class json_reader
+	{
+	public:
+
+		json_reader(arena* a = nullptr, parse_options const& options = parse_options::global())
+			: m_arena(a), m_in_situ(options.in_situ), m_validate_utf8(options.validate_utf8), m_pool(options.pool), m_pool_limit(options.pool_limit)
+			, m_threads(options.threads ? options.threads : std::thread::hardware_concurrency()) {}
+	
+		bool parse_file(char const* filename, value& result, std::string* errors)
+		{
+			file_view file(filename);
+			if (file.is_open())
 			{
-				sb
-				<< static_cast<char>(((code >> 12) & 0x1f) | 0xe0)
-				<< static_cast<char>(((code >> 6)  & 0x3f) | 0x80)
-				<< static_cast<char>((code & 0x3f) | 0x80);
+				m_in_situ = false; // the text is gone after parsing
+				return parse_string(file.data(), result, errors, file.limit());
 			}
 			else
 			{
-				sb
-				<< static_cast<char>(((code >> 18) & 0x1f) | 0xf0)
-				<< static_cast<char>(((code >> 12) & 0x3f) | 0x80)
-				<< static_cast<char>(((code >> 6)  & 0x3f) | 0x80)
-				<< static_cast<char>((code & 0x3f) | 0x80);
+				if (errors) *errors = "failed to load file '" + std::string(filename) + "'";
+				return false;
 			}
 		}
 		
-		void read_escaped_symbol(strbuf_t& sb)
+		// limit is where readable memory ends, by default just past the terminating zero
+		bool parse_string(char const* string, value& result, std::string* errors, char const* limit = nullptr)
 		{
-			if (*++source)
-			{
-				switch (*source)
-				{
-					case '"':  sb << '"';  break;
-					case '/':  sb << '/';  break;
-					case '\\': sb << '\\'; break;
-					case 'b':  sb << '\b'; break;
-					case 'f':  sb << '\f'; break;
-					case 'n':  sb << '\n'; break;
-					case 'r':  sb << '\r'; break;
-					case 't':  sb << '\t'; break;
-					case 'u':  read_unicode_symbol(sb); break;
-					default: throw fail("invalid escaped symbol");
-				}
-				++source;
-			}
-			else
+			if (!string) result = value();
+			if (m_threads > 1 && !m_arena) return parse_parallel(string, limit, result, errors);
+			return parse(string, 1, limit, errors, [&] { read_value(result); });
+		}
+
+		template <typename Handler> bool parse_events(char const* string, Handler& handler, std::string* errors)
+		{
+			return parse(string, 1, nullptr, errors, [&] { read_event(handler); });
+		}
+
+		// result is null unless the path leads somewhere
+		template <typename Steps> bool parse_path(char const* string, Steps const& steps, value& result, std::string* errors)
+		{
+			bool found = false;
+			bool ok = parse(string, 1, nullptr, errors, [&] { found = read_path(steps, result); });
+			if (!found) result = value();
+			return ok && found;
+		}
+
+		// MARK: cursor moves
+		// Each one starts at the value `at` points to and leaves at, line and key at the value it
+		// reaches; key is where the pair starts for object members and nullptr for array elements.
+		// Malformed text counts as having nothing there. limit is where the readable text ends.
+
+		template <typename Step> bool seek_child(char const*& at, std::size_t& line, char const*& key, char const* limit, Step const& step)
+		{
+			bool found = false;
+			key = nullptr;
+			return parse(at, line, limit, nullptr, [&] { if ((found = seek(step, &key))) { at = source; line = line_num; } }) && found;
+		}
+
+		bool seek_first(char const*& at, std::size_t& line, char const*& key, char const* limit)
+		{
+			bool found = false;
+			return parse(at, line, limit, nullptr, [&]
 			{
-				throw fail("unexpected end of escaped symbol");
-			}
+				bool pairs = *source++ == '{';
+				found = enter(pairs, at, line, key);
+			}) && found;
 		}
-		
-		char const* read_string()
+
+		bool seek_next(char const*& at, std::size_t& line, char const*& key, char const* limit)
 		{
-			strbuf.clear();
-			++source;
-			while (*source)
+			bool found = false;
+			return parse(at, line, limit, nullptr, [&]
 			{
-				char const* end = source;
-				while (*end != '\\' && *end != '"' && *end != '\0') ++end;
-				
-				if (source != end)
-				{
-					strbuf.write(source, end - source);
-					source = end;
-				}
-				
-				if (*source == '\\')
+				skip_value();
+				skip_whitespaces();
+				if (*source == ',')
 				{
-					read_escaped_symbol(strbuf);
+					++source;
+					found = enter(key != nullptr, at, line, key);
 				}
-				else if (*source == '"')
+				else if (*source != ']' && *source != '}')
 				{
-					++source;
-					strbuf << '\0';
-					return strbuf.data();
+					throw fail("missing comma");
 				}
-			}
-			throw fail("unexpected end of string");
+			}) && found;
 		}
-	};
-
-#pragma mark -
 
-	// MARK: json serializer
-	class json_writer
-	{
-	public:
+		bool seek_end(char const* at, std::size_t line, char const* limit, char const*& end)
+		{
+			return parse(at, line, limit, nullptr, [&] { skip_value(); end = source; });
+		}
 
-		json_writer(strbuf_t& buf) : m_buf(buf) {}
+		bool read_key(char const* key, std::size_t line, char const* limit, std::string& result)
+		{
+			return parse(key, line, limit, nullptr, [&] { string_ref k = read_string(); result.assign(k.data(), k.size()); });
+		}
 
-		void write(value const& v, serialize_options const& options)
+		bool parse_at(char const* at, std::size_t line, char const* limit, value& result, std::string* errors)
 		{
-			m_buf.clear();
-			m_options = options;
-			m_indents = 0;
-			write_value(v);
-			m_buf << '\0';
+			return parse(at, line, limit, errors, [&] { read_value(result); });
 		}
 
+		// reports the single string, number or literal in [begin, end) as a value or key event;
+		// the text need not be terminated, a delimiter follows it
+		template <typename Handler> bool parse_token(char const* begin, char const* end, bool is_key, std::size_t line, Handler& handler, std::string* errors)
+		{
+			return parse(begin, line, end, errors, [&]
+			{
+				if (is_key) emit(handler.key(read_string()));
+				else read_event(handler);
+				if (source != end) throw fail("invalid value");
+			});
+		}
+		
 	private:
-
-		json_writer(json_writer const&) = delete;
-		json_writer(json_writer&&) = delete;
-		json_writer& operator = (json_writer const&) = delete;
-		json_writer& operator = (json_writer&&) = delete;
-
-		strbuf_t&         m_buf;
-		int               m_indents;
-		serialize_options m_options;
 		
-		void write_float(double n, int precision)
-		{
-			double const ln10 = 2.30258509299404568402;
+		struct stopped {}; // a handler returned false
 
-			if (n == 0) m_buf << '0';
-			else if (std::isinf(n) || std::isnan(n)) m_buf.write("null", 4);
-			else
+		template <typename Body> bool parse(char const* string, std::size_t line, char const* limit, std::string* errors, Body const& body)
+		{
+			line_num = line;
+			if (string)
 			{
-				thread_local char buf[128];
-				char* dst = buf;
-				
-				if (n < 0)
-				{
-					*dst++ = '-';
-					n = -n;
-				}
-				
-				long p_f = exp(precision * ln10);// pow10(precision);
-				long integ = floor(n);
-				long fract = floor((n - integ) * p_f + 0.5);
-				
-				if (fract == p_f)
-				{
-					++integ;
-					fract = 0;
-				}
-				
-				if (integ > 0)
+				source  = string;
+				m_limit = limit ? limit : string + strlen(string) + 1;
+				try
 				{
-					int log_i = log10(integ);
-					long p_i = exp(log_i * ln10);//pow10(log_i);
-					for (int i=0; i<=log_i; ++i)
-					{
-						long dig = integ / p_i;
-						integ -= dig * p_i;
-						*dst++ = dig + 48;
-						p_i /= 10;
-					}
+					body();
+					return true;
 				}
-				else
+				catch (stopped const&)
 				{
-					*dst++ = '0';
+					if (errors) *errors = "stopped by handler";
+					return false;
 				}
-				
-				if (fract > 0)
+				catch (std::exception const &ex)
 				{
-					*dst++ = '.';
-					for (int i=0; i<precision; ++i)
+					if (errors)
 					{
-						p_f /= 10;
-						if (fract == 0) break;
-						long dig = fract / p_f;
-						fract -= dig * p_f;
-						*dst++ = dig + 48;
+						std::ostringstream oss;
+						oss << ex.what() << " at line " << line_num;
+						*errors = oss.str();
 					}
+					return false;
 				}
-				
-				m_buf.write(buf, dst - buf);
 			}
-		}
-		
-		template <typename T> void write_integer(T n)
+			else
+			{
+				if (errors) *errors = "no data";
+				return false;
+			}
+		}
+		
+		char const*  source;
+		char const*  m_limit; // loads of several bytes at once stay below this
+		std::size_t  line_num;
+		strbuf_t     strbuf;
+		arena*       m_arena;
+		bool         m_in_situ;
+		bool         m_validate_utf8;
+		string_pool* m_pool;
+		std::size_t  m_pool_limit;
+		unsigned     m_threads;
+		
+		void skip_whitespaces()
 		{
-			thread_local char buf[32] = { 0 };
-
-			bool neg = false;
-			if (n < 0)
+			if (scanner::is_space(*source)) source = scanner::skip_spaces(source, m_limit, line_num);
+			if (!*source) throw fail("unexpected end of document");
+		}
+		
+		void read_value(value& val)
+		{
+			skip_whitespaces();
+			switch (*source)
 			{
-				neg = true;
-				n = 0 - n;
+				case '[': read_array (val); break;
+				case '{': read_object(val); break;
+				case '"': read_string(val); break;
+				case 'n': skip_check("null");  val = value(); break;
+				case 't': skip_check("true");  val = true;    break;
+				case 'f': skip_check("false"); val = false;   break;
+				default:  read_number(val); break;
 			}
-			
-			char* end = buf + sizeof(buf) - 1;
-			char* ptr = end;
-			
-			do
+		}
+		
+		void skip_check(char const* str)
+		{
+			for (char const* p = str; *p; ++p)
 			{
-				*ptr-- = '0' + n % 10;
-				n = n / 10;
-			} while (n != 0);
-			
-			if (neg) *ptr-- = '-';
-			
-			m_buf.write(ptr + 1, end - ptr);
+				if (*source++ != *p)
+				{
+					std::string err = "expected ";
+					err += str;
+					throw fail(err.c_str());
+				}
+			}
 		}
-
-		void write_string(char const* str)
+		
+		void read_object(value& val)
 		{
-			while (*str)
+			++source;
+			val = value(type::object, m_arena);
+			while (*source)
 			{
-				auto write_word = [&](uint16_t word)
+				skip_whitespaces();
+				
+				if (*source == '}')
 				{
-					char chars[6] = { '\\', 'u' };
-					for (int i=0; i<4; ++i)
-					{
-						char c = word & 0x0f;
-						word >>= 4;
-						chars[5 - i] = c < 10 ? c + 48 : c + 87;
-					}
-					m_buf.write(chars, 6);
-				};
-					
-				if (m_options.utf8_escaping && *str < 0)
+					++source;
+					return;
+				}
+				
+				if (*source == '"')
 				{
-					uint8_t const mask[] = { 0x00, 0x00, 0x1f, 0x0f, 0x07 };
-					
-					uint32_t code = static_cast<uint8_t>(*str++);
-					size_t octets = 0;
-					
-					if      ((code & 0xe0) == 0xc0)                   octets = 2;
-					else if ((code & 0xf0) == 0xe0)                   octets = 3;
-					else if ((code & 0xf8) == 0xf0 && (code <= 0xf4)) octets = 4;
-					else throw fail("invalid unicode symbol");
-					
-					code &= mask[octets];
-					for (size_t i=1; i<octets; ++i)
-					{
-						code = (code << 6) | (*str++ & 0x3f);
-					}
-					
-					if (code < 0x10000)
+					string_ref key = read_string();
+					skip_whitespaces();
+					if (*source++ == ':')
 					{
-						write_word(code);
+						skip_whitespaces();
+						read_value(val.data.o->get(key));
+						skip_whitespaces();
+						if      (*source == ',') ++source;
+						else if (*source == '}') { ++source; return; }
+						else throw fail("missing comma in object");
 					}
 					else
 					{
-						code -= 0x10000;
-						write_word((code >> 10)   | 0xd800);
-						write_word((code & 0x3ff) | 0xdc00);
+						throw fail("expected ':' after pair key");
 					}
 				}
 				else
 				{
-					uint8_t code = static_cast<uint8_t>(*str);
-					if (code < 0x20 || code == 0x7f) // control characters must always be escaped
-					{
-						write_word(*str);
-					}
-					else
-					{
-						switch (*str)
-						{
-						case  '"': m_buf << '\\' << '\"'; break;
-						case '\\': m_buf << '\\' << '\\'; break;
-						case '\b': m_buf << '\\' << 'b';  break;
-						case '\f': m_buf << '\\' << 'f';  break;
-						case '\n': m_buf << '\\' << 'n';  break;
-						case '\r': m_buf << '\\' << 'r';  break;
-						case '\t': m_buf << '\\' << 't';  break;
-						default:   m_buf << *str;         break;
-						}
-					}
-					++str;
+					throw fail("expected quoted pair key");
 				}
 			}
+			throw fail("unexpected end of object");
 		}
-		
-		void write_array(value const& v)
+
+		void read_array(value& val)
 		{
-			m_buf << '[';
-			if (!v.data.a->empty())
+			++source;
+			val = value(type::array, m_arena);
+			while (*source)
 			{
-				++m_indents;
-				put_newline();
-				
-				size_t index = 0;
-				for (auto const& it : *v.data.a)
+				skip_whitespaces();
+				if (*source == ']')
 				{
-					put_indents();
-					write_value(it);
-					if (index++ != v.data.a->size() - 1) m_buf << ',';
-					put_newline();
+					++source;
+					return;
 				}
 				
-				--m_indents;
-				put_indents();
+				val.data.a->emplace_back();
+				read_value(val.data.a->back());
+				skip_whitespaces();
+				if      (*source == ',') ++source;
+				else if (*source == ']') { ++source; return; }
+				else throw fail("missing comma in array");
 			}
-			m_buf << ']';
+			throw fail("unexpected end of array");
 		}
 		
-		void write_object(value const& v)
+		// MARK: events
+		// same grammar as the tree readers above, but every token goes straight to the handler
+
+		static void emit(bool go) { if (!go) throw stopped(); }
+
+		template <typename Handler> void read_event(Handler& handler)
 		{
-			m_buf << '{';
-			if (!v.data.o->empty())
+			skip_whitespaces();
+			switch (*source)
 			{
-				++m_indents;
-				put_newline();
-				
-				size_t index = 0;
-				for (auto const& it : v.data.o->object())
+				case '[': read_array_events (handler); break;
+				case '{': read_object_events(handler); break;
+				case '"': emit(handler.string(read_string())); break;
+				case 'n': skip_check("null");  emit(handler.null());         break;
+				case 't': skip_check("true");  emit(handler.boolean(true));  break;
+				case 'f': skip_check("false"); emit(handler.boolean(false)); break;
+				default:
 				{
-					auto const& key = it.first;
-					auto const& val = it.second;
-					
-					put_indents();
-					m_buf << '"';
-					write_string(key.c_str());
-					m_buf << '"' << ':';
+					value number; // numbers never allocate
+					read_number(number);
+					emit(handler.number(static_cast<value const&>(number)));
+					break;
+				}
+			}
+		}
 
-					if (val.size() > 0)
+		template <typename Handler> void read_object_events(Handler& handler)
+		{
+			++source;
+			emit(handler.start_object());
+			while (*source)
+			{
+				skip_whitespaces();
+				
+				if (*source == '}')
+				{
+					++source;
+					emit(handler.end_object());
+					return;
+				}
+				
+				if (*source == '"')
+				{
+					emit(handler.key(read_string()));
+					skip_whitespaces();
+					if (*source++ == ':')
 					{
-						if (m_options.java_style_braces)
-						{
-							put_space();
-						}
-						else
-						{
-							put_newline();
-							put_indents();
-						}
+						read_event(handler);
+						skip_whitespaces();
+						if      (*source == ',') ++source;
+						else if (*source == '}') { ++source; emit(handler.end_object()); return; }
+						else throw fail("missing comma in object");
 					}
 					else
 					{
-						put_space();
+						throw fail("expected ':' after pair key");
 					}
-
-					write_value(val);
-					
-					if (index++ != v.data.o->size() - 1) m_buf << ',';
-
-					put_newline();
 				}
-
-				--m_indents;
-				put_indents();
+				else
+				{
+					throw fail("expected quoted pair key");
+				}
 			}
-			m_buf << '}';
+			throw fail("unexpected end of object");
 		}
 
-		void write_value(value const& v)
+		template <typename Handler> void read_array_events(Handler& handler)
 		{
-			switch (v.type)
+			++source;
+			emit(handler.start_array());
+			while (*source)
 			{
-			case type::null:
-				m_buf.write("null", 4);
-				break;
-				
-			case type::n_double:
-				write_float(v.data.d, m_options.number_precision);
-				break;
-				
-			case type::n_int32:
-				write_integer(v.data.i);
-				break;
+				skip_whitespaces();
+				if (*source == ']')
+				{
+					++source;
+					emit(handler.end_array());
+					return;
+				}
 				
-			case type::n_int64:
-				write_integer(v.data.l);
-				break;
-
-			case type::boolean:
-				v.data.b ? m_buf.write("true", 4) : m_buf.write("false", 5);
-				break;
+				read_event(handler);
+				skip_whitespaces();
+				if      (*source == ',') ++source;
+				else if (*source == ']') { ++source; emit(handler.end_array()); return; }
+				else throw fail("missing comma in array");
+			}
+			throw fail("unexpected end of array");
+		}
 
-			case type::string:
-				m_buf << '"';
-				if (v.data.s) write_string(v.data.s->c_str());
-				m_buf << '"';
-				break;
+		// MARK: parallel arrays
+		// A first pass skips over the elements of a top-level array to find where they start,
+		// since only a scan from the beginning knows which brackets are inside strings. The
+		// elements are then cut into chunks that threads take in turn and parse in full, each
+		// straight into its own slots of the result.
 
-			case type::array:
-				write_array(v);
-				break;
+		static constexpr std::size_t chunk_size = 1 << 20;
 
-			case type::object:
-				write_object(v);
-				break;
-				
-			case type::binary:
-				m_buf.write("\"<binary>\"", 10);
-				break;
-			}
-		}
+		struct chunk
+		{
+			char const* begin;
+			std::size_t line;
+			std::size_t first; // index of the first element
+			std::size_t count;
+		};
 
-		void put_space()
+		bool parse_parallel(char const* string, char const* limit, value& result, std::string* errors)
 		{
-			if (m_options.pretty_print) m_buf << ' ';
-		}
+			std::vector<chunk> chunks;
+			bool is_array = false;
+			bool ok = parse(string, 1, limit, errors, [&]
+			{
+				skip_whitespaces();
+				is_array = *source == '[';
+				if (is_array) split_array(chunks);
+				else read_value(result);
+			});
+			if (!ok || !is_array) return ok;
 
-		void put_newline()
-		{
-			if (m_options.pretty_print) m_buf << '\n';
-		}
-		
-		void put_indents()
-		{
-			if (m_options.pretty_print)
+			std::size_t total = chunks.empty() ? 0 : chunks.back().first + chunks.back().count;
+			result = value(type::array);
+			result.data.a->resize(total);
+
+			parse_options options;
+			options.in_situ = m_in_situ;
+			options.validate_utf8 = m_validate_utf8;
+			options.pool = m_pool;
+			options.pool_limit = m_pool_limit;
+			std::vector<std::string> failures(chunks.size());
+			std::atomic<std::size_t> next(0);
+			limit = m_limit;
+			auto work = [&]
 			{
-				for (int i = 0; i < m_indents; ++i) m_buf.write(m_options.indent);
+				json_reader r(nullptr, options);
+				for (std::size_t i = next++; i < chunks.size(); i = next++)
+				{
+					r.read_chunk(chunks[i], limit, *result.data.a, failures[i]);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (std::size_t i = 1; i < m_threads && i < chunks.size(); ++i) threads.emplace_back(work);
+			work();
+			for (auto& t : threads) t.join();
+
+			for (auto const& failure : failures)
+			{
+				if (!failure.empty())
+				{
+					if (errors) *errors = failure;
+					result = value();
+					return false;
+				}
 			}
+			return true;
 		}
-	};
-	
-#pragma mark -
-	
-	enum bson_t
-	{
-		bson_double   = 0x01,
-		bson_string   = 0x02,
-		bson_document = 0x03,
-		bson_array    = 0x04,
-		bson_binary   = 0x05,
-		// Deprecated   0x06 - Undefined (value)
-		//              0x07 - ObjectId
-		bson_bool     = 0x08,
-		bson_utc_time = 0x09,
-		bson_null     = 0x0a,
-		//              0x0b - regex (cstring, cstring)
-		// Deprecated   0x0c - DBPointer
-		//              0x0d - JavaScript code
-		// Deprecated   0x0e - Symbol
-		// Deprecated   0x0f - JavaScript code w/ scope
-		bson_int32    = 0x10,
-		//              0x11 - Special internal type used by MongoDB replication and sharding. First 4 bytes are an increment, second 4 are a timestamp
-		bson_int64    = 0x12,
-		//              0x13 - 	128-bit decimal floating point
-		//              0xff - 	Min key
-		//              0x7f - 	Max key
-	};
-	
-	// MARK: bson parser
-	class bson_reader
-	{
-	public:
-	
-		bool parse_file(char const* filename, value& result, std::string* errors)
+
+		void split_array(std::vector<chunk>& chunks)
 		{
-			std::ifstream file(filename, std::ios::binary | std::ios::ate);
-			if (file)
+			++source;
+			std::size_t count = 0;
+			while (*source)
 			{
-				thread_local bytes_t data;
-				data.resize(file.tellg());
-				file.seekg(0, std::ios::beg);
-				file.read(data.data(), data.size());
-				return parse_data(data, result, errors);
+				skip_whitespaces();
+				if (*source == ']')
+				{
+					++source;
+					return;
+				}
+
+				if (chunks.empty() || static_cast<std::size_t>(source - chunks.back().begin) >= chunk_size)
+				{
+					chunks.push_back(chunk{ source, line_num, count, 0 });
+				}
+				skip_value();
+				++chunks.back().count;
+				++count;
+				skip_whitespaces();
+				if      (*source == ',') ++source;
+				else if (*source == ']') { ++source; return; }
+				else throw fail("missing comma in array");
 			}
-			else
+			throw fail("unexpected end of array");
+		}
+
+		// the separators were checked by split_array
+		void read_chunk(chunk const& c, char const* limit, array_t& elements, std::string& failure)
+		{
+			parse(c.begin, c.line, limit, &failure, [&]
 			{
-				if (errors) *errors = "failed to load file '" + std::string(filename) + "'";
-				return false;
-			}
+				for (std::size_t i = 0; i < c.count; ++i)
+				{
+					read_value(elements[c.first + i]);
+					skip_whitespaces();
+					++source;
+				}
+			});
 		}
-		
-		bool parse_data(bytes_t const& data, value& result, std::string* errors)
+
+		// MARK: paths
+		// walks down to the value a path names; everything before it is skipped, nothing after it is read
+
+		template <typename Steps> bool read_path(Steps const& steps, value& result)
 		{
-			return parse_data(data.data(), data.size(), result, errors);
+			for (auto const& step : steps)
+			{
+				if (!seek(step, nullptr)) return false;
+			}
+			read_value(result);
+			return true;
 		}
-		
-		bool parse_data(char const* data, size_t size, value& result, std::string* errors)
+
+		// moves from a container to the child that step names by its name or index,
+		// or returns false if there is none; key gets where the pair starts in an object
+		template <typename Step> bool seek(Step const& step, char const** key)
 		{
-			if (size > 0)
+			skip_whitespaces();
+			if (*source == '{')
 			{
-				ptr = data;
-				end = data + size;
-				result = value(type::object);
-				try
-				{
-					read_document(result);
-				}
-				catch (std::exception const& ex)
+				++source;
+				for (;;)
 				{
-					if (errors) *errors = ex.what();
-					return false;
+					skip_whitespaces();
+					if (*source == '}') return false;
+					if (*source != '"') throw fail("expected quoted pair key");
+					char const* start = source;
+					bool match = match_key(step.name.data(), step.name.size());
+					skip_whitespaces();
+					if (*source++ != ':') throw fail("expected ':' after pair key");
+					if (match)
+					{
+						skip_whitespaces();
+						if (key) *key = start;
+						return true;
+					}
+					skip_value();
+					skip_whitespaces();
+					if      (*source == ',') ++source;
+					else if (*source == '}') return false;
+					else throw fail("missing comma in object");
 				}
-				return true;
 			}
-			else
+			else if (*source == '[')
 			{
-				if (errors) *errors = "no data";
-				result = value();
-				return false;
+				++source;
+				for (std::size_t index = 0;; ++index)
+				{
+					skip_whitespaces();
+					if (*source == ']') return false;
+					if (index == step.index) return true;
+					skip_value();
+					skip_whitespaces();
+					if      (*source == ',') ++source;
+					else if (*source == ']') return false;
+					else throw fail("missing comma in array");
+				}
 			}
+			return false; // scalars have no children
 		}
-		
-	private:
-		
-		char const* ptr;
-		char const* end;
-		
-		struct pair_t
-		{
-			uint8_t type;
-			char const* key;
-		};
-		
-		bool read_pair(pair_t& pair)
+
+		// steps into the next element or pair value, false at the end of the container
+		bool enter(bool pair, char const*& at, std::size_t& line, char const*& key)
 		{
-			pair.type = read<uint8_t>();
-			if (pair.type == 0) return false;
-			pair.key = fetch_string();
+			skip_whitespaces();
+			if (*source == ']' || *source == '}') return false;
+			key = nullptr;
+			if (pair)
+			{
+				if (*source != '"') throw fail("expected quoted pair key");
+				key = source;
+				skip_string();
+				skip_whitespaces();
+				if (*source++ != ':') throw fail("expected ':' after pair key");
+			}
+			skip_whitespaces();
+			at = source;
+			line = line_num;
 			return true;
 		}
-		
-		void read_value(uint8_t type, value& tmp)
+
+		// keys without escapes are compared in place, the rest are decoded first
+		bool match_key(char const* name, std::size_t len)
 		{
-			switch (type)
+			char const* begin = source + 1;
+			char const* end = scanner::find_string_special(begin, m_limit);
+			if (*end != '"')
 			{
-				case bson_double:   tmp = read<double>();    break;
-				case bson_int32:    tmp = read<int32_t>();   break;
-				case bson_int64:
-				case bson_utc_time: tmp = read<int64_t>();   break;
-				case bson_bool:     tmp = read<uint8_t>() > 0 ? true : false; break;
-				case bson_null:     tmp = value(type::null); break;
-				
-				case bson_string:
-					(void)read<int32_t>(); // string length
-					tmp = fetch_string();
-					break;
-				
-				case bson_document:
-					tmp = value(type::object);
-					read_document(tmp);
-					break;
-				
-				case bson_array:
-					tmp = value(type::array);
-					read_array(tmp);
-					break;
-				
-				case bson_binary:
-					read_binary(tmp);
-					break;
-				
-				default: throw fail("unsupported bson type id: " + std::to_string(type)); break;
+				string_ref key = read_string();
+				return key.size() == len && memcmp(key.data(), name, len) == 0;
 			}
+			check_utf8(begin, end);
+			source = end + 1;
+			return static_cast<std::size_t>(end - begin) == len && memcmp(begin, name, len) == 0;
 		}
-		
-		void read_binary(value& val)
-		{
-			val = value(type::binary);
-			size_t size = read<int32_t>();
-			auto& data = *val.data.x;
-			data.resize(size);
-			(void)read<uint8_t>(); // subtype
-			check_end(size);
-			memcpy(data.data(), ptr, data.size());
-			ptr += size;
-		}
-		
-		void read_document(value& val)
+
+		// containers are only checked for closed strings and balanced brackets
+		void skip_value()
 		{
-			auto size = read<uint32_t>(); (void)size;
-			pair_t pair;
-			while (read_pair(pair))
+			skip_whitespaces();
+			char c = *source;
+			if (c == '"')
 			{
-				read_value(pair.type, val(pair.key));
+				skip_string();
 			}
-		}
-		
-		void read_array(value& val)
-		{
-			auto size = read<uint32_t>(); (void)size;
-			pair_t pair;
-			while (read_pair(pair))
+			else if (c != '[' && c != '{')
 			{
-				val.data.a->emplace_back();
-				read_value(pair.type, val.data.a->back());
+				value scalar; // literals and numbers never allocate
+				read_value(scalar);
+			}
+			else
+			{
+				std::size_t depth = 0;
+				for (;;)
+				{
+					c = *source;
+					if      (c == '"') { skip_string(); continue; }
+					else if (c == '[' || c == '{') ++depth;
+					else if (c == ']' || c == '}') { if (--depth == 0) { ++source; return; } }
+					else if (c == '\n') ++line_num;
+					else if (c == '\0') throw fail("unexpected end of document");
+					++source;
+				}
 			}
 		}
-		
-		template <typename T> T read()
-		{
-			check_end(sizeof(T));
-			T* t = (T*)ptr;
-			ptr += sizeof(T);
-			return *t;
-		}
-		
-		char const* fetch_string()
+
+		void skip_string()
 		{
-			size_t len = strlen(ptr) + 1;
-			check_end(len);
-			char const* str = ptr;
-			ptr += len;
-			return str;
+			++source;
+			for (;;)
+			{
+				source = scanner::find_string_special(source, m_limit);
+				if (*source == '"') { ++source; return; }
+				if (*source == '\0' || *++source == '\0') break;
+				++source; // the escaped character, \u digits are plain text
+			}
+			throw fail("unexpected end of string");
 		}
-		
-		void check_end(size_t pos)
+
+		// MARK: tokens
+		void read_number(value& val)
 		{
-			if (ptr + pos > end + 1) throw fail("end of data reached");
-		}
-	};
+			char const* start = source;
+			bool negative = false;
+			bool is_float = false;
+			char c = *source;
+			if      (c == '-')             { negative = true; ++source; }
+			else if (c == '+')             { ++source; }
+			else if (c >= '0' && c <= '9') { }
+			else throw fail("invalid numeric value");
 
-#pragma mark -
+			// significant digits are kept exactly while they fit 64 bits, the rest only move the exponent
+			uint64_t mantissa  = 0;
+			int64_t  exponent  = 0;
+			int      digits    = 0;
+			bool     truncated = false;
 
-	// MARK: bson serializer
-	struct bson_writer
-	{
-		bytes_t data;
-		
-		void clear()
-		{
-			data.resize(0);
-		}
-		
-		void write_value(char const* key, value const& val)
-		{
-			switch (val.type)
+			char const* run = source;
+			int kept = read_digits(mantissa, digits, truncated);
+			exponent += (source - run) - kept;
+
+			if (*source == '.')
 			{
-				case type::object:
-				{
-					if (key)
-					{
-						write<uint8_t>(bson_document);
-						write_string(key);
-					}
-					size_t beg = data.size();
-					write<uint32_t>(0); // len
-					for (auto const& it : val.data.o->object())
-					{
-						write_value(it.first.c_str(), it.second);
-					}
-					write<uint8_t>(0x00);
-					uint32_t len = static_cast<uint32_t>(data.size() - beg);
-					write_at(beg, len);
+				is_float = true;
+				++source;
+				exponent -= read_digits(mantissa, digits, truncated);
+			}
+
+			if (*source == 'e' || *source == 'E')
+			{
+				is_float = true;
+				++source;
+				int exp_sign = 1;
+				if      (*source == '-') { ++source; exp_sign = -1; }
+				else if (*source == '+') { ++source; }
+				
+				int64_t exp = 0;
+				while (*source >= '0' && *source <= '9')
+				{
+					if (exp < 100000) exp = exp * 10 + (*source - '0');
+					++source;
+				}
+				
+				exponent += exp * exp_sign;
+			}
+
+			// integers take the smallest exact type, only those beyond 64 bits become doubles
+			if (!is_float && exponent == 0)
+			{
+				if (negative)
+				{
+					if      (mantissa <= uint64_t(INT32_MAX) + 1) { val = static_cast<int32_t>(0 - mantissa); return; }
+					else if (mantissa <= uint64_t(INT64_MAX) + 1) { val = static_cast<int64_t>(0 - mantissa); return; }
+				}
+				else
+				{
+					if      (mantissa <= uint64_t(INT32_MAX)) { val = static_cast<int32_t>(mantissa); return; }
+					else                                      { val = mantissa; return; }
+				}
+			}
+
+			double result = float_parser::convert(mantissa, exponent, negative);
+			if (truncated && result != float_parser::convert(mantissa + 1, exponent, negative))
+			{
+				result = parse_float(start); // dropped digits decide the rounding
+			}
+			val = result;
+		}
+
+		// reads a run of digits into mantissa, returns how many were kept
+		int read_digits(uint64_t& mantissa, int& digits, bool& truncated)
+		{
+			int  kept   = 0;
+			bool chunks = true;
+			while (*source >= '0' && *source <= '9')
+			{
+				// chunks only follow a significant digit, so leading zeros cannot inflate the count
+				if (chunks && mantissa && digits <= 11)
+				{
+					if (scanner::eight_digits(source, m_limit, mantissa))
+					{
+						source += 8;
+						digits += 8;
+						kept   += 8;
+						continue;
+					}
+					chunks = false;
+				}
+
+				int dig = *source++ - '0';
+				if (digits < 19 || (digits == 19 && mantissa <= (UINT64_MAX - dig) / 10))
+				{
+					mantissa = mantissa * 10 + dig;
+					if (mantissa) ++digits;
+					++kept;
+				}
+				else
+				{
+					digits = 20; // nothing more fits once a digit is dropped
+					truncated |= dig != 0;
+				}
+			}
+			return kept;
+		}
+
+		double parse_float(char const* start)
+		{
+			// strtod rounds correctly, but expects the decimal point of the current C locale
+			char point = *std::localeconv()->decimal_point;
+			strbuf.clear();
+			for (char const* p = start; p != source; ++p) strbuf << (*p == '.' ? point : *p);
+			strbuf << '\0';
+			return std::strtod(strbuf.data(), nullptr);
+		}
+		
+		template <typename Sink> static void read_unicode_symbol(char const*& p, Sink& sb)
+		{
+			auto read_word = [&]()
+			{
+				uint16_t code = 0;
+				for (int i=0; i<4; ++i)
+				{
+					uint16_t sym = p[i+1];
+					if (!sym) throw fail("unexpected end of unicode symbol");
+					if      (sym >= '0' && sym <= '9') sym -= 48;
+					else if (sym >= 'a' && sym <= 'f') sym -= 87;
+					else if (sym >= 'A' && sym <= 'F') sym -= 55;
+					else throw fail("invalid hex value");
+					code = (code << 4) | sym;
+				}
+				p += 4;
+				return code;
+			};
+			
+			uint32_t code = 0;
+			uint16_t first = read_word();
+			if (first < 0xd800 || first > 0xdfff)
+			{
+				code = first;
+			}
+			else if (first >= 0xdc00)
+			{
+				throw fail("invalid unicode symbol");
+			}
+			else
+			{
+				if (p[1] != '\\' || p[2] != 'u') throw fail("invalid unicode symbol");
+				p += 2;
+			
+				uint16_t second = read_word();
+				code = (first & 0x3ff) << 10;
+				if (second < 0xdc00 || second > 0xdfff)
+				{
+					throw fail("invalid unicode symbol");
+				}
+				else
+				{
+					code = code | (second & 0x3ff);
+					code += 0x10000;
+				}
+			}
+			
+			if (code < 0x80)
+			{
+				sb << static_cast<char>(code);
+			}
+			else if (code < 0x800)
+			{
+				sb
+				<< static_cast<char>(((code >> 6) & 0x1f) | 0xc0)
+				<< static_cast<char>((code & 0x3f) | 0x80);
+			}
+			else if (code < 0x10000)
+			{
+				sb
+				<< static_cast<char>(((code >> 12) & 0x0f) | 0xe0)
+				<< static_cast<char>(((code >> 6)  & 0x3f) | 0x80)
+				<< static_cast<char>((code & 0x3f) | 0x80);
+			}
+			else
+			{
+				sb
+				<< static_cast<char>(((code >> 18) & 0x07) | 0xf0)
+				<< static_cast<char>(((code >> 12) & 0x3f) | 0x80)
+				<< static_cast<char>(((code >> 6)  & 0x3f) | 0x80)
+				<< static_cast<char>((code & 0x3f) | 0x80);
+			}
+		}
+		
+		// p points at the backslash and is left past the escape sequence
+		template <typename Sink> static void read_escaped_symbol(char const*& p, Sink& sb)
+		{
+			if (*++p)
+			{
+				switch (*p)
+				{
+					case '"':  sb << '"';  break;
+					case '/':  sb << '/';  break;
+					case '\\': sb << '\\'; break;
+					case 'b':  sb << '\b'; break;
+					case 'f':  sb << '\f'; break;
+					case 'n':  sb << '\n'; break;
+					case 'r':  sb << '\r'; break;
+					case 't':  sb << '\t'; break;
+					case 'u':  read_unicode_symbol(p, sb); break;
+					default: throw fail("invalid escaped symbol");
+				}
+				++p;
+			}
+			else
+			{
+				throw fail("unexpected end of escaped symbol");
+			}
+		}
+		
+		void read_string(value& val)
+		{
+			if (m_in_situ)
+			{
+				// only strings without escapes are borrowed, the rest is decoded into a copy below
+				char const* begin = source + 1;
+				char const* end = scanner::find_string_special(begin, m_limit);
+				std::size_t len = end - begin;
+				if (*end == '"' && len >= short_capacity && len <= UINT32_MAX)
+				{
+					check_utf8(begin, end);
+					val = value(type::string);
+					val.set_external(begin, len, storage::view);
+					source = end + 1;
+					return;
+				}
+			}
+			string_ref str = read_string();
+			val = m_pool && str.size() <= m_pool_limit ? value(str, *m_pool) : value(str, m_arena);
+		}
+
+		// escapes always decode to valid UTF-8, so only the raw runs between them are checked
+		void check_utf8(char const* begin, char const* end)
+		{
+			if (m_validate_utf8 && !scanner::valid_utf8(begin, end)) throw fail("invalid utf-8 in string");
+		}
+
+		string_ref read_string()
+		{
+			strbuf.clear();
+			++source;
+			while (*source)
+			{
+				char const* end = scanner::find_string_special(source, m_limit);
+				check_utf8(source, end);
+				
+				if (source != end)
+				{
+					strbuf.write(source, end - source);
+					source = end;
+				}
+				
+				if (*source == '\\')
+				{
+					read_escaped_symbol(source, strbuf);
+				}
+				else if (*source == '"')
+				{
+					++source;
+					strbuf << '\0';
+					return string_ref(strbuf.data(), strbuf.size() - 1);
+				}
+			}
+			throw fail("unexpected end of string");
+		}
+	};
+
+#pragma mark -
+
+	// MARK: double to decimal
+	struct float_writer
+	{
+		// shortest digits that read back to the same double
+		static char* shortest(double value, char* dst)
+		{
+			if (value < 0)
+			{
+				*dst++ = '-';
+				value = -value;
+			}
+
+			char digits[20];
+			int  length = 0;
+			int  exponent = 0;
+			grisu2(value, digits, length, exponent);
+			while (length > 1 && shorten(value, digits, length, exponent)) {}
+			return format(digits, length, exponent, dst);
+		}
+
+		// at most `precision` digits after the point, trailing zeros removed
+		static char* fixed(double value, int precision, char* dst)
+		{
+			if (precision > 17) precision = 17;
+			if (value < 0 ? value <= -1e18 : value >= 1e18) return shortest(value, dst); // integer part won't fit
+			if (value < 0)
+			{
+				*dst++ = '-';
+				value = -value;
+			}
+
+			uint64_t p_f   = pow10(precision);
+			uint64_t integ = static_cast<uint64_t>(value);
+			uint64_t fract = static_cast<uint64_t>((value - static_cast<double>(integ)) * static_cast<double>(p_f) + 0.5);
+			if (fract >= p_f)
+			{
+				++integ;
+				fract = 0;
+			}
+
+			dst = write_digits(integ, dst);
+			if (fract > 0)
+			{
+				*dst++ = '.';
+				for (int i = precision - 1; i >= 0; --i)
+				{
+					dst[i] = static_cast<char>('0' + fract % 10);
+					fract /= 10;
+				}
+				dst += precision;
+				while (dst[-1] == '0') --dst;
+			}
+			return dst;
+		}
+
+	private:
+
+		struct diyfp // f * 2^e
+		{
+			uint64_t f;
+			int      e;
+
+			diyfp(uint64_t f_, int e_) : f(f_), e(e_) {}
+
+			diyfp operator - (diyfp const& y) const { return diyfp(f - y.f, e); }
+
+			diyfp operator * (diyfp const& y) const // upper 64 bits of the product, rounded
+			{
+				uint64_t u_lo = f & 0xffffffff, u_hi = f >> 32;
+				uint64_t v_lo = y.f & 0xffffffff, v_hi = y.f >> 32;
+				uint64_t p0 = u_lo * v_lo, p1 = u_lo * v_hi, p2 = u_hi * v_lo, p3 = u_hi * v_hi;
+				uint64_t q = (p0 >> 32) + (p1 & 0xffffffff) + (p2 & 0xffffffff) + (uint64_t(1) << 31);
+				return diyfp(p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32), e + y.e + 64);
+			}
+
+			diyfp normalized() const
+			{
+				diyfp x = *this;
+				while (!(x.f >> 63))
+				{
+					x.f <<= 1;
+					--x.e;
+				}
+				return x;
+			}
+		};
+
+		struct cached_power // 10^k ~ f * 2^e
+		{
+			uint64_t f;
+			int      e;
+			int      k;
+		};
+
+		static void grisu2(double value, char* digits, int& length, int& exponent)
+		{
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			uint64_t const hidden = uint64_t(1) << 52;
+			uint64_t fraction = bits & (hidden - 1);
+			int      biased   = static_cast<int>(bits >> 52);
+
+			diyfp v = biased == 0 ? diyfp(fraction, 1 - 1075) : diyfp(fraction + hidden, biased - 1075);
+
+			// boundaries halfway to the neighbouring doubles; the lower one is closer at powers of two
+			diyfp m_plus = diyfp(2 * v.f + 1, v.e - 1).normalized();
+			diyfp m_minus = fraction == 0 && biased > 1 ? diyfp(4 * v.f - 1, v.e - 2) : diyfp(2 * v.f - 1, v.e - 1);
+			m_minus = diyfp(m_minus.f << (m_minus.e - m_plus.e), m_plus.e);
+			v = v.normalized();
+
+			// scale by 10^-k so the binary exponent lands in [-60, -32]
+			cached_power const& cached = power_for_exponent(m_plus.e);
+			diyfp c(cached.f, cached.e);
+			diyfp w = v * c;
+			diyfp w_minus = m_minus * c;
+			diyfp w_plus  = m_plus * c;
+
+			// stay strictly inside the rounding interval to absorb the multiplication error
+			diyfp lower(w_minus.f + 1, w_minus.e);
+			diyfp upper(w_plus.f - 1, w_plus.e);
+
+			exponent = -cached.k;
+			generate_digits(digits, length, exponent, lower, w, upper);
+		}
+
+		static void generate_digits(char* digits, int& length, int& exponent, diyfp lower, diyfp w, diyfp upper)
+		{
+			uint64_t delta = (upper - lower).f;
+			uint64_t dist  = (upper - w).f;
+
+			diyfp one(uint64_t(1) << -upper.e, upper.e);
+			uint32_t p1 = static_cast<uint32_t>(upper.f >> -one.e); // integral part
+			uint64_t p2 = upper.f & (one.f - 1);                    // fractional part
+
+			uint32_t pow = 1000000000;
+			int n = 10;
+			while (n > 1 && p1 < pow)
+			{
+				pow /= 10;
+				--n;
+			}
+
+			while (n > 0)
+			{
+				digits[length++] = static_cast<char>('0' + p1 / pow);
+				p1 %= pow;
+				--n;
+				uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+				if (rest <= delta)
+				{
+					exponent += n;
+					round_weed(digits, length, dist, delta, rest, uint64_t(pow) << -one.e);
+					return;
+				}
+				pow /= 10;
+			}
+
+			int m = 0;
+			for (;;)
+			{
+				p2 *= 10;
+				digits[length++] = static_cast<char>('0' + (p2 >> -one.e));
+				p2 &= one.f - 1;
+				++m;
+				delta *= 10;
+				dist  *= 10;
+				if (p2 <= delta) break;
+			}
+			exponent -= m;
+			round_weed(digits, length, dist, delta, p2, one.f);
+		}
+
+		// Grisu2 always round-trips, but once in a while a shorter candidate sits in the margin it
+		// leaves for its own rounding error; exact parsing tells whether one digit less reads back
+		static bool shorten(double value, char* digits, int& length, int& exponent)
+		{
+			uint64_t w = 0;
+			for (int i=0; i<length - 1; ++i) w = w * 10 + (digits[i] - '0');
+
+			bool down = float_parser::convert(w, exponent + 1, false) == value;
+			bool up   = float_parser::convert(w + 1, exponent + 1, false) == value;
+			if (!down && !up) return false;
+			if (up && (!down || digits[length - 1] >= '5')) ++w;
+
+			exponent += 1;
+			while (w % 10 == 0)
+			{
+				w /= 10;
+				++exponent;
+			}
+			length = static_cast<int>(write_digits(w, digits) - digits);
+			return true;
+		}
+
+		// moves the last digit towards w while it stays inside the interval
+		static void round_weed(char* digits, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k)
+		{
+			while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist))
+			{
+				--digits[length - 1];
+				rest += ten_k;
+			}
+		}
+
+		static cached_power const& power_for_exponent(int e)
+		{
+			static cached_power const powers[] =
+			{
+				{ 0xAB70FE17C79AC6CA, -1060, -300 },
+				{ 0xFF77B1FCBEBCDC4F, -1034, -292 },
+				{ 0xBE5691EF416BD60C, -1007, -284 },
+				{ 0x8DD01FAD907FFC3C,  -980, -276 },
+				{ 0xD3515C2831559A83,  -954, -268 },
+				{ 0x9D71AC8FADA6C9B5,  -927, -260 },
+				{ 0xEA9C227723EE8BCB,  -901, -252 },
+				{ 0xAECC49914078536D,  -874, -244 },
+				{ 0x823C12795DB6CE57,  -847, -236 },
+				{ 0xC21094364DFB5637,  -821, -228 },
+				{ 0x9096EA6F3848984F,  -794, -220 },
+				{ 0xD77485CB25823AC7,  -768, -212 },
+				{ 0xA086CFCD97BF97F4,  -741, -204 },
+				{ 0xEF340A98172AACE5,  -715, -196 },
+				{ 0xB23867FB2A35B28E,  -688, -188 },
+				{ 0x84C8D4DFD2C63F3B,  -661, -180 },
+				{ 0xC5DD44271AD3CDBA,  -635, -172 },
+				{ 0x936B9FCEBB25C996,  -608, -164 },
+				{ 0xDBAC6C247D62A584,  -582, -156 },
+				{ 0xA3AB66580D5FDAF6,  -555, -148 },
+				{ 0xF3E2F893DEC3F126,  -529, -140 },
+				{ 0xB5B5ADA8AAFF80B8,  -502, -132 },
+				{ 0x87625F056C7C4A8B,  -475, -124 },
+				{ 0xC9BCFF6034C13053,  -449, -116 },
+				{ 0x964E858C91BA2655,  -422, -108 },
+				{ 0xDFF9772470297EBD,  -396, -100 },
+				{ 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+				{ 0xF8A95FCF88747D94,  -343,  -84 },
+				{ 0xB94470938FA89BCF,  -316,  -76 },
+				{ 0x8A08F0F8BF0F156B,  -289,  -68 },
+				{ 0xCDB02555653131B6,  -263,  -60 },
+				{ 0x993FE2C6D07B7FAC,  -236,  -52 },
+				{ 0xE45C10C42A2B3B06,  -210,  -44 },
+				{ 0xAA242499697392D3,  -183,  -36 },
+				{ 0xFD87B5F28300CA0E,  -157,  -28 },
+				{ 0xBCE5086492111AEB,  -130,  -20 },
+				{ 0x8CBCCC096F5088CC,  -103,  -12 },
+				{ 0xD1B71758E219652C,   -77,   -4 },
+				{ 0x9C40000000000000,   -50,    4 },
+				{ 0xE8D4A51000000000,   -24,   12 },
+				{ 0xAD78EBC5AC620000,     3,   20 },
+				{ 0x813F3978F8940984,    30,   28 },
+				{ 0xC097CE7BC90715B3,    56,   36 },
+				{ 0x8F7E32CE7BEA5C70,    83,   44 },
+				{ 0xD5D238A4ABE98068,   109,   52 },
+				{ 0x9F4F2726179A2245,   136,   60 },
+				{ 0xED63A231D4C4FB27,   162,   68 },
+				{ 0xB0DE65388CC8ADA8,   189,   76 },
+				{ 0x83C7088E1AAB65DB,   216,   84 },
+				{ 0xC45D1DF942711D9A,   242,   92 },
+				{ 0x924D692CA61BE758,   269,  100 },
+				{ 0xDA01EE641A708DEA,   295,  108 },
+				{ 0xA26DA3999AEF774A,   322,  116 },
+				{ 0xF209787BB47D6B85,   348,  124 },
+				{ 0xB454E4A179DD1877,   375,  132 },
+				{ 0x865B86925B9BC5C2,   402,  140 },
+				{ 0xC83553C5C8965D3D,   428,  148 },
+				{ 0x952AB45CFA97A0B3,   455,  156 },
+				{ 0xDE469FBD99A05FE3,   481,  164 },
+				{ 0xA59BC234DB398C25,   508,  172 },
+				{ 0xF6C69A72A3989F5C,   534,  180 },
+				{ 0xB7DCBF5354E9BECE,   561,  188 },
+				{ 0x88FCF317F22241E2,   588,  196 },
+				{ 0xCC20CE9BD35C78A5,   614,  204 },
+				{ 0x98165AF37B2153DF,   641,  212 },
+				{ 0xE2A0B5DC971F303A,   667,  220 },
+				{ 0xA8D9D1535CE3B396,   694,  228 },
+				{ 0xFB9B7CD9A4A7443C,   720,  236 },
+				{ 0xBB764C4CA7A44410,   747,  244 },
+				{ 0x8BAB8EEFB6409C1A,   774,  252 },
+				{ 0xD01FEF10A657842C,   800,  260 },
+				{ 0x9B10A4E5E9913129,   827,  268 },
+				{ 0xE7109BFBA19C0C9D,   853,  276 },
+				{ 0xAC2820D9623BF429,   880,  284 },
+				{ 0x80444B5E7AA7CF85,   907,  292 },
+				{ 0xBF21E44003ACDD2D,   933,  300 },
+				{ 0x8E679C2F5E44FF8F,   960,  308 },
+				{ 0xD433179D9C8CB841,   986,  316 },
+				{ 0x9E19DB92B4E31BA9,  1013,  324 }
+			};
+
+			int f = -60 - e - 1;
+			int k = (f * 78913) / (1 << 18) + (f > 0);
+			return powers[(300 + k + 7) / 8];
+		}
+
+		// decimal notation for points in (-6, 21], exponent otherwise
+		static char* format(char const* digits, int length, int exponent, char* dst)
+		{
+			int point = length + exponent;
+			if (length <= point && point <= 21)
+			{
+				memcpy(dst, digits, length);
+				memset(dst + length, '0', point - length);
+				return dst + point;
+			}
+			if (0 < point && point <= 21)
+			{
+				memcpy(dst, digits, point);
+				dst[point] = '.';
+				memcpy(dst + point + 1, digits + point, length - point);
+				return dst + length + 1;
+			}
+			if (-6 < point && point <= 0)
+			{
+				*dst++ = '0';
+				*dst++ = '.';
+				memset(dst, '0', -point);
+				memcpy(dst - point, digits, length);
+				return dst - point + length;
+			}
+
+			*dst++ = digits[0];
+			if (length > 1)
+			{
+				*dst++ = '.';
+				memcpy(dst, digits + 1, length - 1);
+				dst += length - 1;
+			}
+			*dst++ = 'e';
+			int e = point - 1;
+			if (e < 0)
+			{
+				*dst++ = '-';
+				e = -e;
+			}
+			return write_digits(static_cast<uint64_t>(e), dst);
+		}
+
+		static char* write_digits(uint64_t n, char* dst)
+		{
+			char tmp[20];
+			char* p = tmp + sizeof(tmp);
+			do
+			{
+				*--p = static_cast<char>('0' + n % 10);
+				n /= 10;
+			} while (n != 0);
+			std::size_t len = tmp + sizeof(tmp) - p;
+			memcpy(dst, p, len);
+			return dst + len;
+		}
+
+		static uint64_t pow10(int n)
+		{
+			uint64_t p = 1;
+			while (n-- > 0) p *= 10;
+			return p;
+		}
+	};
+
+#pragma mark -
+
+	// MARK: json serializer
+	class json_writer
+	{
+	public:
+
+		json_writer(strbuf_t& buf) : m_buf(buf) {}
+
+		void write(value const& v, serialize_options const& options)
+		{
+			m_buf.clear();
+			set_options(options);
+			write_value(v);
+			m_buf << '\0';
+		}
+
+		// the buffer must have a sink, output goes there as it is produced
+		bool stream(value const& v, serialize_options const& options)
+		{
+			m_buf.clear();
+			set_options(options);
+			write_value(v);
+			return m_buf.flush();
+		}
+
+	private:
+
+		json_writer(json_writer const&) = delete;
+		json_writer(json_writer&&) = delete;
+		json_writer& operator = (json_writer const&) = delete;
+		json_writer& operator = (json_writer&&) = delete;
+
+		strbuf_t&         m_buf;
+		int               m_indents;
+		serialize_options m_options;
+
+		void set_options(serialize_options const& options)
+		{
+			m_options = options;
+			if (m_options.threads == 0) m_options.threads = std::thread::hardware_concurrency();
+			m_indents = 0;
+		}
+		
+		void write_float(double n, int precision)
+		{
+			if (n == 0) m_buf << '0';
+			else if (std::isinf(n) || std::isnan(n)) m_buf.write("null", 4);
+			else
+			{
+				char buf[64];
+				char* end = precision < 0 ? float_writer::shortest(n, buf) : float_writer::fixed(n, precision, buf);
+				m_buf.write(buf, end - buf);
+			}
+		}
+		
+		template <typename T> void write_integer(T n)
+		{
+			thread_local char buf[32] = { 0 };
+
+			// negating in unsigned arithmetic keeps INT64_MIN intact
+			bool neg = n < T(0);
+			uint64_t u = neg ? 0 - static_cast<uint64_t>(n) : static_cast<uint64_t>(n);
+			
+			char* end = buf + sizeof(buf) - 1;
+			char* ptr = end;
+			
+			do
+			{
+				*ptr-- = '0' + u % 10;
+				u = u / 10;
+			} while (u != 0);
+			
+			if (neg) *ptr-- = '-';
+			
+			m_buf.write(ptr + 1, end - ptr);
+		}
+
+		void write_string(char const* str, std::size_t len)
+		{
+			char const* end = str + len;
+			while (str != end)
+			{
+				// bytes that need no escaping are copied as one run
+				char const* run = scanner::find_escape(str, end, m_options.utf8_escaping);
+				if (run != str)
+				{
+					m_buf.write(str, run - str);
+					str = run;
+					if (str == end) break;
+				}
+
+				auto write_word = [&](uint16_t word)
+				{
+					char chars[6] = { '\\', 'u' };
+					for (int i=0; i<4; ++i)
+					{
+						char c = word & 0x0f;
+						word >>= 4;
+						chars[5 - i] = c < 10 ? c + 48 : c + 87;
+					}
+					m_buf.write(chars, 6);
+				};
+					
+				if (m_options.utf8_escaping && *str < 0)
+				{
+					uint8_t const mask[] = { 0x00, 0x00, 0x1f, 0x0f, 0x07 };
+					
+					uint32_t code = static_cast<uint8_t>(*str++);
+					size_t octets = 0;
+					
+					if      ((code & 0xe0) == 0xc0)                   octets = 2;
+					else if ((code & 0xf0) == 0xe0)                   octets = 3;
+					else if ((code & 0xf8) == 0xf0 && (code <= 0xf4)) octets = 4;
+					else throw fail("invalid unicode symbol");
+					if (static_cast<std::size_t>(end - str) < octets - 1) throw fail("invalid unicode symbol");
+					
+					code &= mask[octets];
+					for (size_t i=1; i<octets; ++i)
+					{
+						code = (code << 6) | (*str++ & 0x3f);
+					}
+					
+					if (code < 0x10000)
+					{
+						write_word(code);
+					}
+					else
+					{
+						code -= 0x10000;
+						write_word((code >> 10)   | 0xd800);
+						write_word((code & 0x3ff) | 0xdc00);
+					}
+				}
+				else
+				{
+					uint8_t code = static_cast<uint8_t>(*str);
+					if (code < 0x20 || code == 0x7f) // control characters must always be escaped
+					{
+						write_word(*str);
+					}
+					else
+					{
+						switch (*str)
+						{
+						case  '"': m_buf << '\\' << '\"'; break;
+						case '\\': m_buf << '\\' << '\\'; break;
+						case '\b': m_buf << '\\' << 'b';  break;
+						case '\f': m_buf << '\\' << 'f';  break;
+						case '\n': m_buf << '\\' << 'n';  break;
+						case '\r': m_buf << '\\' << 'r';  break;
+						case '\t': m_buf << '\\' << 't';  break;
+						default:   m_buf << *str;         break;
+						}
+					}
+					++str;
+				}
+			}
+		}
+		
+		void write_array(value const& v)
+		{
+			m_buf << '[';
+			if (!v.data.a->empty())
+			{
+				++m_indents;
+				put_newline();
+				
+				array_t const& array = *v.data.a;
+				if (m_options.threads > 1 && array.size() >= parallel_threshold)
+				{
+					write_parallel(array.size(), [&](json_writer& w, std::size_t i) { w.write_element(array[i], i == array.size() - 1); });
+				}
+				else
+				{
+					for (std::size_t i = 0; i < array.size(); ++i) write_element(array[i], i == array.size() - 1);
+				}
+				
+				--m_indents;
+				put_indents();
+			}
+			m_buf << ']';
+		}
+		
+		void write_object(value const& v)
+		{
+			m_buf << '{';
+			if (!v.data.o->empty())
+			{
+				++m_indents;
+				put_newline();
+				
+				object_t const& object = v.data.o->object();
+				if (m_options.threads > 1 && object.size() >= parallel_threshold)
+				{
+					write_parallel(object.size(), [&](json_writer& w, std::size_t i) { w.write_member(object[i], i == object.size() - 1); });
+				}
+				else
+				{
+					for (std::size_t i = 0; i < object.size(); ++i) write_member(object[i], i == object.size() - 1);
+				}
+
+				--m_indents;
+				put_indents();
+			}
+			m_buf << '}';
+		}
+
+		void write_element(value const& val, bool last)
+		{
+			put_indents();
+			write_value(val);
+			if (!last) m_buf << ',';
+			put_newline();
+		}
+
+		void write_member(pair_t const& pair, bool last)
+		{
+			auto const& key = pair.first;
+			auto const& val = pair.second;
+
+			put_indents();
+			m_buf << '"';
+			write_string(key.data(), key.size());
+			m_buf << '"' << ':';
+
+			if (val.size() > 0)
+			{
+				if (m_options.java_style_braces)
+				{
+					put_space();
+				}
+				else
+				{
+					put_newline();
+					put_indents();
+				}
+			}
+			else
+			{
+				put_space();
+			}
+
+			write_value(val);
+			if (!last) m_buf << ',';
+			put_newline();
+		}
+
+		// MARK: parallel output
+		// Ranges of children are formatted on other threads, each into a buffer of its own by a
+		// writer at the same indentation, and copied out in order. Threads stay at most a few
+		// ranges ahead of the copying, so streamed output keeps its memory bound.
+
+		static constexpr std::size_t parallel_threshold = 1024; // children
+		static constexpr std::size_t range_limit        = 1024;
+
+		struct range_slot
+		{
+			strbuf_t           buf;
+			std::exception_ptr failure;
+			bool               done = false;
+		};
+
+		template <typename Child> void write_parallel(std::size_t count, Child const& write_child)
+		{
+			std::size_t threads   = m_options.threads;
+			std::size_t per_range = count / (threads * 16);
+			if (per_range == 0) per_range = 1;
+			if (per_range > range_limit) per_range = range_limit;
+			std::size_t ranges    = (count + per_range - 1) / per_range;
+			std::size_t window    = threads * 2;
+			std::vector<range_slot> slots(window);
+
+			std::mutex              mutex;
+			std::condition_variable changed;
+			std::size_t             next    = 0;
+			std::size_t             written = 0;
+			bool                    aborted = false;
+
+			auto work = [&]
+			{
+				for (;;)
+				{
+					std::size_t i;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [&] { return aborted || next >= ranges || next < written + window; });
+						if (aborted || next >= ranges) return;
+						i = next++;
+					}
+
+					range_slot& slot = slots[i % window];
+					slot.buf.clear();
+					try
+					{
+						json_writer w(slot.buf);
+						w.m_options = m_options;
+						w.m_options.threads = 1;
+						w.m_indents = m_indents;
+						for (std::size_t k = i * per_range; k < std::min(count, (i + 1) * per_range); ++k) write_child(w, k);
+					}
+					catch (...)
+					{
+						slot.failure = std::current_exception();
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					slot.done = true;
+					changed.notify_all();
+				}
+			};
+
+			std::vector<std::thread> pool;
+			for (std::size_t t = 0; t < threads; ++t) pool.emplace_back(work);
+
+			std::exception_ptr failure;
+			for (std::size_t i = 0; i < ranges && !failure; ++i)
+			{
+				range_slot& slot = slots[i % window];
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [&] { return slot.done; });
+				}
+				failure = slot.failure;
+				if (!failure) m_buf.write(slot.buf.data(), slot.buf.size());
+
+				std::lock_guard<std::mutex> lock(mutex);
+				slot.done = false;
+				++written;
+				aborted = failure != nullptr;
+				changed.notify_all();
+			}
+
+			for (auto& t : pool) t.join();
+			if (failure) std::rethrow_exception(failure);
+		}
+
+		void write_value(value const& v)
+		{
+			switch (v.type)
+			{
+			case type::null:
+				m_buf.write("null", 4);
+				break;
+				
+			case type::n_double:
+				write_float(v.data.d, m_options.number_precision);
+				break;
+				
+			case type::n_int32:
+				write_integer(v.data.i);
+				break;
+				
+			case type::n_int64:
+				write_integer(v.data.l);
+				break;
+
+			case type::n_uint64:
+				write_integer(v.data.u);
+				break;
+
+			case type::boolean:
+				v.data.b ? m_buf.write("true", 4) : m_buf.write("false", 5);
+				break;
+
+			case type::string:
+				m_buf << '"';
+				write_string(v.str_data(), v.str_size());
+				m_buf << '"';
+				break;
+
+			case type::array:
+				write_array(v);
+				break;
+
+			case type::object:
+				write_object(v);
+				break;
+				
+			case type::binary:
+				m_buf.write("\"<binary>\"", 10);
+				break;
+			}
+		}
+
+		void put_space()
+		{
+			if (m_options.pretty_print) m_buf << ' ';
+		}
+
+		void put_newline()
+		{
+			if (m_options.pretty_print) m_buf << '\n';
+		}
+		
+		void put_indents()
+		{
+			if (m_options.pretty_print)
+			{
+				for (int i = 0; i < m_indents; ++i) m_buf.write(m_options.indent);
+			}
+		}
+	};
+	
+#pragma mark -
+	
+	enum bson_t
+	{
+		bson_double   = 0x01,
+		bson_string   = 0x02,
+		bson_document = 0x03,
+		bson_array    = 0x04,
+		bson_binary   = 0x05,
+		// Deprecated   0x06 - Undefined (value)
+		//              0x07 - ObjectId
+		bson_bool     = 0x08,
+		bson_utc_time = 0x09,
+		bson_null     = 0x0a,
+		//              0x0b - regex (cstring, cstring)
+		// Deprecated   0x0c - DBPointer
+		//              0x0d - JavaScript code
+		// Deprecated   0x0e - Symbol
+		// Deprecated   0x0f - JavaScript code w/ scope
+		bson_int32    = 0x10,
+		//              0x11 - Special internal type used by MongoDB replication and sharding. First 4 bytes are an increment, second 4 are a timestamp
+		bson_int64    = 0x12,
+		//              0x13 - 	128-bit decimal floating point
+		//              0xff - 	Min key
+		//              0x7f - 	Max key
+	};
+	
+	// MARK: bson parser
+	class bson_reader
+	{
+	public:
+
+		bson_reader(arena* a = nullptr, parse_options const& options = parse_options::global())
+			: m_arena(a), m_in_situ(options.in_situ), m_pool(options.pool), m_pool_limit(options.pool_limit) {}
+	
+		bool parse_file(char const* filename, value& result, std::string* errors)
+		{
+			file_view file(filename);
+			if (file.is_open())
+			{
+				m_in_situ = false; // the mapping is gone after parsing
+				return parse_data(file.data(), file.size(), result, errors);
+			}
+			else
+			{
+				if (errors) *errors = "failed to load file '" + std::string(filename) + "'";
+				return false;
+			}
+		}
+		
+		bool parse_data(bytes_t const& data, value& result, std::string* errors)
+		{
+			return parse_data(data.data(), data.size(), result, errors);
+		}
+		
+		bool parse_data(char const* data, size_t size, value& result, std::string* errors)
+		{
+			if (size > 0)
+			{
+				ptr = data;
+				end = data + size;
+				result = value(type::object, m_arena);
+				try
+				{
+					read_document(result);
+				}
+				catch (std::exception const& ex)
+				{
+					if (errors) *errors = ex.what();
+					return false;
+				}
+				return true;
+			}
+			else
+			{
+				if (errors) *errors = "no data";
+				result = value();
+				return false;
+			}
+		}
+
+		// reads the value of one element, for bson_view
+		bool parse_value(uint8_t type, char const* data, char const* data_end, value& result, std::string* errors)
+		{
+			ptr = data;
+			end = data_end;
+			try
+			{
+				read_value(type, result);
+				return true;
+			}
+			catch (std::exception const& ex)
+			{
+				if (errors) *errors = ex.what();
+				result = value();
+				return false;
+			}
+		}
+		
+	private:
+		
+		char const*  ptr;
+		char const*  end;
+		arena*       m_arena;
+		bool         m_in_situ;
+		string_pool* m_pool;
+		std::size_t  m_pool_limit;
+		
+		struct pair_t
+		{
+			uint8_t type;
+			char const* key;
+		};
+		
+		bool read_pair(pair_t& pair)
+		{
+			pair.type = read<uint8_t>();
+			if (pair.type == 0) return false;
+			pair.key = fetch_string();
+			return true;
+		}
+		
+		void read_value(uint8_t type, value& tmp)
+		{
+			switch (type)
+			{
+				case bson_double:   tmp = read<double>();    break;
+				case bson_int32:    tmp = read<int32_t>();   break;
+				case bson_int64:
+				case bson_utc_time: tmp = read<int64_t>();   break;
+				case bson_bool:     tmp = read<uint8_t>() > 0 ? true : false; break;
+				case bson_null:     tmp = value(type::null); break;
+				
+				case bson_string:
+				{
+					(void)read<int32_t>(); // string length
+					char const* str = fetch_string();
+					std::size_t len = ptr - str - 1;
+					if (m_in_situ && len >= short_capacity && len <= UINT32_MAX)
+					{
+						tmp = value(type::string);
+						tmp.set_external(str, len);
+					}
+					else
+					{
+						tmp = m_pool && len <= m_pool_limit ? value(string_ref(str, len), *m_pool) : value(string_ref(str, len), m_arena);
+					}
+					break;
+				}
+				
+				case bson_document:
+					tmp = value(type::object, m_arena);
+					read_document(tmp);
+					break;
+				
+				case bson_array:
+					tmp = value(type::array, m_arena);
+					read_array(tmp);
+					break;
+				
+				case bson_binary:
+					read_binary(tmp);
+					break;
+				
+				default: throw fail("unsupported bson type id: " + std::to_string(type)); break;
+			}
+		}
+		
+		void read_binary(value& val)
+		{
+			val = value(type::binary);
+			size_t size = read<int32_t>();
+			(void)read<uint8_t>(); // subtype
+			check_end(size); // before allocating, the declared size may be anything
+			auto& data = *val.data.x;
+			data.resize(size);
+			memcpy(data.data(), ptr, data.size());
+			ptr += size;
+		}
+		
+		void read_document(value& val)
+		{
+			auto size = read<uint32_t>(); (void)size;
+			pair_t pair;
+			while (read_pair(pair))
+			{
+				read_value(pair.type, val(pair.key));
+			}
+		}
+		
+		void read_array(value& val)
+		{
+			auto size = read<uint32_t>(); (void)size;
+			pair_t pair;
+			while (read_pair(pair))
+			{
+				val.data.a->emplace_back();
+				read_value(pair.type, val.data.a->back());
+			}
+		}
+		
+		template <typename T> T read()
+		{
+			check_end(sizeof(T));
+			T t;
+			memcpy(&t, ptr, sizeof(T)); // fields are not aligned
+			ptr += sizeof(T);
+			return t;
+		}
+		
+		char const* fetch_string()
+		{
+			char const* terminator = static_cast<char const*>(memchr(ptr, 0, end - ptr));
+			if (!terminator) throw fail("end of data reached");
+			char const* str = ptr;
+			ptr = terminator + 1;
+			return str;
+		}
+		
+		void check_end(size_t pos)
+		{
+			if (pos > static_cast<size_t>(end - ptr)) throw fail("end of data reached");
+		}
+	};
+
+#pragma mark -
+
+	// MARK: bson serializer
+	// size() works out the exact length first, so write() fills memory of that size
+	// with no reallocation, no bounds checks and no temporary strings.
+	struct bson_writer
+	{
+		static std::size_t size(value const& root)
+		{
+			if (root.type != type::object) throw fail("bson documents must be objects");
+			return value_size(root);
+		}
+
+		// out must have room for size(root) bytes, returns the end of the document
+		static char* write(value const& root, char* out)
+		{
+			if (root.type != type::object) throw fail("bson documents must be objects");
+			return write_value(root, out);
+		}
+
+	private:
+
+		// "0" to "999" with their terminators, longer index keys are written digit by digit
+		struct index_keys
+		{
+			char text[1000][4];
+
+			index_keys()
+			{
+				for (int i=0; i<1000; ++i) snprintf(text[i], sizeof(text[i]), "%d", i);
+			}
+
+			static index_keys const& get()
+			{
+				static index_keys keys;
+				return keys;
+			}
+		};
+
+		static std::size_t index_size(std::size_t i)
+		{
+			std::size_t digits = 1;
+			while (i >= 10) { i /= 10; ++digits; }
+			return digits + 1;
+		}
+
+		static std::size_t value_size(value const& val)
+		{
+			switch (val.type)
+			{
+				case type::object:
+				{
+					std::size_t size = 5; // length and terminator
+					for (auto const& it : val.data.o->object())
+					{
+						size += 2 + strlen(it.first.c_str()) + value_size(it.second);
+					}
+					return size;
+				}
+
+				case type::array:
+				{
+					std::size_t size = 5;
+					for (std::size_t i=0; i<val.data.a->size(); ++i)
+					{
+						size += 1 + index_size(i) + value_size((*val.data.a)[i]);
+					}
+					return size;
+				}
+
+				case type::n_double: return 8;
+				case type::n_int32:  return 4;
+				case type::n_int64:  return 8;
+				case type::boolean:  return 1;
+				case type::string:   return 5 + val.str_size();
+				case type::binary:   return 5 + val.data.x->size();
+				case type::null:     return 0;
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+		static uint8_t type_id(value const& val)
+		{
+			switch (val.type)
+			{
+				case type::object:   return bson_document;
+				case type::array:    return bson_array;
+				case type::n_double: return bson_double;
+				case type::n_int32:  return bson_int32;
+				case type::n_int64:  return bson_int64;
+				case type::boolean:  return bson_bool;
+				case type::string:   return bson_string;
+				case type::binary:   return bson_binary;
+				default:             return bson_null;
+			}
+		}
+
+		static char* write_value(value const& val, char* out)
+		{
+			switch (val.type)
+			{
+				case type::object:
+				{
+					char* beg = out;
+					out += 4; // length
+					for (auto const& it : val.data.o->object())
+					{
+						*out++ = type_id(it.second);
+						out = put(out, it.first.c_str(), strlen(it.first.c_str()) + 1);
+						out = write_value(it.second, out);
+					}
+					*out++ = 0x00;
+					put_uint32(beg, static_cast<uint32_t>(out - beg));
+					return out;
+				}
+
+				case type::array:
+				{
+					index_keys const& keys = index_keys::get();
+					char* beg = out;
+					out += 4; // length
+					for (std::size_t i=0; i<val.data.a->size(); ++i)
+					{
+						value const& element = (*val.data.a)[i];
+						*out++ = type_id(element);
+						if (i < 1000)
+						{
+							out = put(out, keys.text[i], index_size(i));
+						}
+						else
+						{
+							std::size_t len = index_size(i) - 1;
+							for (std::size_t n = i, k = len; k-- > 0; n /= 10) out[k] = '0' + n % 10;
+							out[len] = '\0';
+							out += len + 1;
+						}
+						out = write_value(element, out);
+					}
+					*out++ = 0x00;
+					put_uint32(beg, static_cast<uint32_t>(out - beg));
+					return out;
+				}
+
+				case type::n_double: return put(out, &val.data.d, 8);
+				case type::n_int32:  return put(out, &val.data.i, 4);
+				case type::n_int64:  return put(out, &val.data.l, 8);
+
+				case type::boolean:
+					*out++ = val.data.b ? 1 : 0;
+					return out;
+
+				case type::string:
+					out = put_uint32(out, static_cast<uint32_t>(val.str_size() + 1));
+					out = put(out, val.str_data(), val.str_size());
+					*out++ = 0x00;
+					return out;
+
+				case type::binary:
+					out = put_uint32(out, static_cast<uint32_t>(val.data.x->size()));
+					*out++ = 0x00; // subtype
+					return put(out, val.data.x->data(), val.data.x->size());
+
+				case type::null:
+					return out;
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+		static char* put(char* out, void const* ptr, std::size_t size)
+		{
+			memcpy(out, ptr, size);
+			return out + size;
+		}
+
+		static char* put_uint32(char* out, uint32_t val) { return put(out, &val, sizeof(val)); }
+	};
+
+#pragma mark -
+
+	// MARK: msgpack and cbor parsers
+	// Both formats put the type and the length in front of every item, so arrays and objects
+	// are allocated at their final size and strings are copied once, or not at all in situ.
+	// Any value can be the root. Map keys must be strings; CBOR tags are skipped. The input is
+	// usually untrusted, so nesting, tags included, is limited to max_depth levels of recursion.
+	class packed_reader
+	{
+	public:
+
+		packed_reader(arena* a, parse_options const& options)
+			: m_arena(a), m_in_situ(options.in_situ), m_validate_utf8(options.validate_utf8), m_pool(options.pool), m_pool_limit(options.pool_limit) {}
+
+	protected:
+
+		char const*  ptr;
+		char const*  end;
+		arena*       m_arena;
+		bool         m_in_situ;
+		bool         m_validate_utf8;
+		string_pool* m_pool;
+		std::size_t  m_pool_limit;
+		std::size_t  m_depth = 0;
+
+		static constexpr std::size_t max_depth = 512;
+
+		// held for each value being read
+		struct nesting
+		{
+			std::size_t& depth;
+			explicit nesting(std::size_t& depth) : depth(depth) { if (++depth > max_depth) throw fail("invalid nesting depth"); }
+			~nesting() { --depth; }
+		};
+
+		template <typename Read> bool parse(char const* data, std::size_t size, value& result, std::string* errors, Read read)
+		{
+			if (size == 0)
+			{
+				if (errors) *errors = "no data";
+				result = value();
+				return false;
+			}
+
+			ptr = data;
+			end = data + size;
+			m_depth = 0;
+			try
+			{
+				read(result);
+				if (ptr != end) throw fail("unexpected data after value");
+			}
+			catch (std::exception const& ex)
+			{
+				if (errors) *errors = ex.what();
+				result = value();
+				return false;
+			}
+			return true;
+		}
+
+		uint8_t byte()
+		{
+			check_end(1);
+			return static_cast<uint8_t>(*ptr++);
+		}
+
+		// big endian
+		template <typename T> T read_uint()
+		{
+			check_end(sizeof(T));
+			T val = 0;
+			for (std::size_t i=0; i<sizeof(T); ++i) val = static_cast<T>(val << 8 | static_cast<uint8_t>(ptr[i]));
+			ptr += sizeof(T);
+			return val;
+		}
+
+		template <typename F, typename T> F read_float()
+		{
+			T bits = read_uint<T>();
+			F val;
+			memcpy(&val, &bits, sizeof(val));
+			return val;
+		}
+
+		// integers that fit are stored as int32, like numbers parsed from text
+		static void set_unsigned(value& val, uint64_t n)
+		{
+			val = n <= INT32_MAX ? value(static_cast<int32_t>(n)) : value(n);
+		}
+
+		static void set_signed(value& val, int64_t n)
+		{
+			val = n >= INT32_MIN && n <= INT32_MAX ? value(static_cast<int32_t>(n)) : value(n);
+		}
+
+		string_ref fetch(uint64_t len)
+		{
+			check_end(len);
+			string_ref str(ptr, static_cast<std::size_t>(len));
+			ptr += len;
+			return str;
+		}
+
+		string_ref check_utf8(string_ref str)
+		{
+			if (m_validate_utf8 && !scanner::valid_utf8(str.begin(), str.end())) throw fail("invalid utf-8 in string");
+			return str;
+		}
+
+		void make_string(value& val, string_ref str, bool borrow)
+		{
+			check_utf8(str);
+			if (borrow && m_in_situ && str.size() >= short_capacity && str.size() <= UINT32_MAX)
+			{
+				val = value(type::string);
+				val.set_external(str.data(), str.size(), storage::view);
+			}
+			else
+			{
+				val = m_pool && str.size() <= m_pool_limit ? value(str, *m_pool) : value(str, m_arena);
+			}
+		}
+
+		void make_binary(value& val, string_ref data)
+		{
+			val = value(type::binary);
+			val.data.x->assign(data.begin(), data.end());
+		}
+
+		// every item takes at least one byte, so a count the data can't hold is rejected before allocating
+		std::size_t check_count(uint64_t count, std::size_t item_size)
+		{
+			if (count > static_cast<uint64_t>(end - ptr) / item_size) throw fail("end of data reached");
+			return static_cast<std::size_t>(count);
+		}
+
+		void check_end(uint64_t size)
+		{
+			if (size > static_cast<uint64_t>(end - ptr)) throw fail("end of data reached");
+		}
+	};
+
+	class msgpack_reader : public packed_reader
+	{
+	public:
+
+		msgpack_reader(arena* a = nullptr, parse_options const& options = parse_options::global()) : packed_reader(a, options) {}
+
+		bool parse_data(char const* data, std::size_t size, value& result, std::string* errors)
+		{
+			return parse(data, size, result, errors, [this](value& val) { read_value(val); });
+		}
+
+	private:
+
+		void read_value(value& val)
+		{
+			nesting level(m_depth);
+			uint8_t id = byte();
+			if (id <= 0x7f) { val = value(static_cast<int32_t>(id)); return; }
+			if (id >= 0xe0) { val = value(static_cast<int32_t>(static_cast<int8_t>(id))); return; }
+			if (id >= 0xa0 && id <= 0xbf) { make_string(val, fetch(id & 0x1f), true); return; }
+			if (id >= 0x90 && id <= 0x9f) { read_array(val, id & 0x0f); return; }
+			if (id >= 0x80 && id <= 0x8f) { read_map(val, id & 0x0f); return; }
+
+			switch (id)
+			{
+				case 0xc0: val = value(type::null); break;
+				case 0xc2: val = false; break;
+				case 0xc3: val = true;  break;
+
+				case 0xc4: make_binary(val, fetch(read_uint<uint8_t>()));  break;
+				case 0xc5: make_binary(val, fetch(read_uint<uint16_t>())); break;
+				case 0xc6: make_binary(val, fetch(read_uint<uint32_t>())); break;
+
+				case 0xca: val = read_float<float, uint32_t>();  break;
+				case 0xcb: val = read_float<double, uint64_t>(); break;
+
+				case 0xcc: set_unsigned(val, read_uint<uint8_t>());  break;
+				case 0xcd: set_unsigned(val, read_uint<uint16_t>()); break;
+				case 0xce: set_unsigned(val, read_uint<uint32_t>()); break;
+				case 0xcf: set_unsigned(val, read_uint<uint64_t>()); break;
+
+				case 0xd0: set_signed(val, static_cast<int8_t>(read_uint<uint8_t>()));   break;
+				case 0xd1: set_signed(val, static_cast<int16_t>(read_uint<uint16_t>())); break;
+				case 0xd2: set_signed(val, static_cast<int32_t>(read_uint<uint32_t>())); break;
+				case 0xd3: set_signed(val, static_cast<int64_t>(read_uint<uint64_t>())); break;
+
+				case 0xd9: make_string(val, fetch(read_uint<uint8_t>()), true);  break;
+				case 0xda: make_string(val, fetch(read_uint<uint16_t>()), true); break;
+				case 0xdb: make_string(val, fetch(read_uint<uint32_t>()), true); break;
+
+				case 0xdc: read_array(val, read_uint<uint16_t>()); break;
+				case 0xdd: read_array(val, read_uint<uint32_t>()); break;
+				case 0xde: read_map(val, read_uint<uint16_t>());   break;
+				case 0xdf: read_map(val, read_uint<uint32_t>());   break;
+
+				default: throw fail("unsupported msgpack type id: " + std::to_string(id)); break;
+			}
+		}
+
+		void read_array(value& val, uint64_t count)
+		{
+			val = value(type::array, m_arena);
+			val.data.a->resize(check_count(count, 1));
+			for (auto& element : *val.data.a) read_value(element);
+		}
+
+		void read_map(value& val, uint64_t count)
+		{
+			std::size_t n = check_count(count, 2);
+			val = value(type::object, m_arena);
+			val.data.o->reserve(n);
+			for (std::size_t i=0; i<n; ++i)
+			{
+				string_ref key = read_key();
+				read_value(val.data.o->get(key));
+			}
+		}
+
+		string_ref read_key()
+		{
+			uint8_t id = byte();
+			if (id >= 0xa0 && id <= 0xbf) return check_utf8(fetch(id & 0x1f));
+			switch (id)
+			{
+				case 0xd9: return check_utf8(fetch(read_uint<uint8_t>()));
+				case 0xda: return check_utf8(fetch(read_uint<uint16_t>()));
+				case 0xdb: return check_utf8(fetch(read_uint<uint32_t>()));
+				default:   throw fail("map keys must be strings");
+			}
+		}
+	};
+
+	class cbor_reader : public packed_reader
+	{
+	public:
+
+		cbor_reader(arena* a = nullptr, parse_options const& options = parse_options::global()) : packed_reader(a, options) {}
+
+		bool parse_data(char const* data, std::size_t size, value& result, std::string* errors)
+		{
+			return parse(data, size, result, errors, [this](value& val) { read_value(val); });
+		}
+
+	private:
+
+		enum major_t : uint8_t
+		{
+			cbor_unsigned = 0,
+			cbor_negative = 1,
+			cbor_bytes    = 2,
+			cbor_text     = 3,
+			cbor_array    = 4,
+			cbor_map      = 5,
+			cbor_tag      = 6,
+			cbor_simple   = 7
+		};
+
+		static constexpr uint8_t indefinite = 31;
+
+		std::string m_chunks; // indefinite length strings are put together here
+
+		void read_value(value& val)
+		{
+			nesting level(m_depth);
+			uint8_t head  = byte();
+			uint8_t major = head >> 5;
+			uint8_t info  = head & 0x1f;
+
+			if (major == cbor_simple)
+			{
+				switch (info)
+				{
+					case 20: val = false; break;
+					case 21: val = true;  break;
+					case 22:
+					case 23: val = value(type::null); break; // undefined reads as null
+					case 25: val = half_to_double(read_uint<uint16_t>()); break;
+					case 26: val = read_float<float, uint32_t>();  break;
+					case 27: val = read_float<double, uint64_t>(); break;
+					default: throw fail("unsupported cbor simple value: " + std::to_string(info)); break;
+				}
+				return;
+			}
+
+			if (info == indefinite)
+			{
+				switch (major)
+				{
+					case cbor_bytes: make_binary(val, read_chunks(major)); break;
+					case cbor_text:  make_string(val, read_chunks(major), false); break;
+
+					case cbor_array:
+						val = value(type::array, m_arena);
+						while (!at_break())
+						{
+							val.data.a->emplace_back();
+							read_value(val.data.a->back());
+						}
+						break;
+
+					case cbor_map:
+						val = value(type::object, m_arena);
+						while (!at_break())
+						{
+							string_ref key = read_key();
+							read_value(val.data.o->get(key));
+						}
+						break;
+
+					default: throw fail("invalid indefinite length"); break;
+				}
+				return;
+			}
+
+			uint64_t arg = read_argument(info);
+			switch (major)
+			{
+				case cbor_unsigned: set_unsigned(val, arg); break;
+
+				case cbor_negative:
+					if (arg > INT64_MAX) throw fail("negative integer out of range");
+					set_signed(val, -1 - static_cast<int64_t>(arg));
+					break;
+
+				case cbor_bytes: make_binary(val, fetch(arg)); break;
+				case cbor_text:  make_string(val, fetch(arg), true); break;
+
+				case cbor_array:
+					val = value(type::array, m_arena);
+					val.data.a->resize(check_count(arg, 1));
+					for (auto& element : *val.data.a) read_value(element);
+					break;
+
+				case cbor_map:
+				{
+					std::size_t n = check_count(arg, 2);
+					val = value(type::object, m_arena);
+					val.data.o->reserve(n);
+					for (std::size_t i=0; i<n; ++i)
+					{
+						string_ref key = read_key();
+						read_value(val.data.o->get(key));
+					}
 					break;
 				}
-				
-				case type::array:
+
+				case cbor_tag: read_value(val); break; // the tagged item is read as it is
+			}
+		}
+
+		string_ref read_key()
+		{
+			uint8_t head = byte();
+			if (head >> 5 != cbor_text) throw fail("map keys must be strings");
+			if ((head & 0x1f) == indefinite) return check_utf8(read_chunks(cbor_text));
+			return check_utf8(fetch(read_argument(head & 0x1f)));
+		}
+
+		uint64_t read_argument(uint8_t info)
+		{
+			if (info < 24) return info;
+			switch (info)
+			{
+				case 24: return read_uint<uint8_t>();
+				case 25: return read_uint<uint16_t>();
+				case 26: return read_uint<uint32_t>();
+				case 27: return read_uint<uint64_t>();
+				default: throw fail("invalid cbor length");
+			}
+		}
+
+		// the chunks of an indefinite length string are definite strings of the same type
+		string_ref read_chunks(uint8_t major)
+		{
+			m_chunks.clear();
+			while (!at_break())
+			{
+				uint8_t head = byte();
+				if (head >> 5 != major || (head & 0x1f) == indefinite) throw fail("invalid string chunk");
+				string_ref chunk = fetch(read_argument(head & 0x1f));
+				m_chunks.append(chunk.data(), chunk.size());
+			}
+			return string_ref(m_chunks.data(), m_chunks.size());
+		}
+
+		bool at_break()
+		{
+			check_end(1);
+			if (static_cast<uint8_t>(*ptr) != 0xff) return false;
+			++ptr;
+			return true;
+		}
+
+		static double half_to_double(uint16_t half)
+		{
+			int exponent = (half >> 10) & 0x1f;
+			int mantissa = half & 0x3ff;
+			double val = exponent == 0  ? std::ldexp(mantissa, -24)
+			           : exponent != 31 ? std::ldexp(mantissa + 1024, exponent - 25)
+			           : mantissa == 0  ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+			return half & 0x8000 ? -val : val;
+		}
+	};
+
+#pragma mark -
+
+	// MARK: msgpack and cbor serializers
+	// As with BSON, size() works out the exact length so write() fills memory of that size
+	// in one pass. Integers and lengths take the shortest form, and doubles that a float holds
+	// exactly are written as floats.
+	struct packed_writer
+	{
+	protected:
+
+		static bool fits_float(double d)
+		{
+			return std::fabs(d) <= std::numeric_limits<float>::max() && static_cast<double>(static_cast<float>(d)) == d;
+		}
+
+		static char* put(char* out, void const* ptr, std::size_t size)
+		{
+			if (size) memcpy(out, ptr, size); // empty binaries have no data pointer
+			return out + size;
+		}
+
+		// big endian
+		template <typename T> static char* put_uint(char* out, T val)
+		{
+			for (std::size_t i = sizeof(T); i-- > 0; val = static_cast<T>(val >> 8)) out[i] = static_cast<char>(val & 0xff);
+			return out + sizeof(T);
+		}
+
+		static char* put_double(char* out, double d)
+		{
+			if (fits_float(d))
+			{
+				float f = static_cast<float>(d);
+				uint32_t bits;
+				memcpy(&bits, &f, sizeof(bits));
+				return put_uint(out, bits);
+			}
+			uint64_t bits;
+			memcpy(&bits, &d, sizeof(bits));
+			return put_uint(out, bits);
+		}
+	};
+
+	struct msgpack_writer : packed_writer
+	{
+		static std::size_t size(value const& root)
+		{
+			return value_size(root);
+		}
+
+		// out must have room for size(val) bytes, returns the end of the encoding
+		static char* write(value const& val, char* out)
+		{
+			switch (val.type)
+			{
+				case type::object:
+					out = put_head(out, val.data.o->size(), 0x80, 0xde);
+					for (auto const& it : val.data.o->object())
+					{
+						out = put_string(out, it.first.data(), it.first.size());
+						out = write(it.second, out);
+					}
+					return out;
+
+				case type::array:
+					out = put_head(out, val.data.a->size(), 0x90, 0xdc);
+					for (auto const& element : *val.data.a) out = write(element, out);
+					return out;
+
+				case type::null:
+					*out++ = static_cast<char>(0xc0);
+					return out;
+
+				case type::boolean:
+					*out++ = static_cast<char>(val.data.b ? 0xc3 : 0xc2);
+					return out;
+
+				case type::n_double:
+					*out++ = static_cast<char>(fits_float(val.data.d) ? 0xca : 0xcb);
+					return put_double(out, val.data.d);
+
+				case type::n_int32:  return put_integer(out, val.data.i);
+				case type::n_int64:  return put_integer(out, val.data.l);
+				case type::n_uint64: return put_unsigned(out, val.data.u);
+				case type::string:   return put_string(out, val.str_data(), val.str_size());
+
+				case type::binary:
+				{
+					std::size_t len = val.data.x->size();
+					if      (len <= UINT8_MAX)  { *out++ = static_cast<char>(0xc4); out = put_uint(out, static_cast<uint8_t>(len)); }
+					else if (len <= UINT16_MAX) { *out++ = static_cast<char>(0xc5); out = put_uint(out, static_cast<uint16_t>(len)); }
+					else                        { *out++ = static_cast<char>(0xc6); out = put_uint(out, static_cast<uint32_t>(len)); }
+					return put(out, val.data.x->data(), len);
+				}
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+	private:
+
+		static std::size_t value_size(value const& val)
+		{
+			switch (val.type)
+			{
+				case type::object:
+				{
+					std::size_t size = container_size(val.data.o->size());
+					for (auto const& it : val.data.o->object())
+					{
+						size += string_size(it.first.size()) + it.first.size() + value_size(it.second);
+					}
+					return size;
+				}
+
+				case type::array:
+				{
+					std::size_t size = container_size(val.data.a->size());
+					for (auto const& element : *val.data.a) size += value_size(element);
+					return size;
+				}
+
+				case type::null:
+				case type::boolean:  return 1;
+				case type::n_double: return fits_float(val.data.d) ? 5 : 9;
+				case type::n_int32:  return integer_size(val.data.i);
+				case type::n_int64:  return integer_size(val.data.l);
+				case type::n_uint64: return unsigned_size(val.data.u);
+				case type::string:   return string_size(val.str_size()) + val.str_size();
+				case type::binary:   return binary_size(val.data.x->size()) + val.data.x->size();
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+		static std::size_t unsigned_size(uint64_t n)
+		{
+			return n <= 0x7f ? 1 : n <= UINT8_MAX ? 2 : n <= UINT16_MAX ? 3 : n <= UINT32_MAX ? 5 : 9;
+		}
+
+		static std::size_t integer_size(int64_t n)
+		{
+			if (n >= 0) return unsigned_size(static_cast<uint64_t>(n));
+			return n >= -32 ? 1 : n >= INT8_MIN ? 2 : n >= INT16_MIN ? 3 : n >= INT32_MIN ? 5 : 9;
+		}
+
+		static std::size_t string_size(std::size_t len)
+		{
+			if (len > UINT32_MAX) throw fail("string too long for msgpack");
+			return len < 32 ? 1 : len <= UINT8_MAX ? 2 : len <= UINT16_MAX ? 3 : 5;
+		}
+
+		static std::size_t binary_size(std::size_t len)
+		{
+			if (len > UINT32_MAX) throw fail("binary too long for msgpack");
+			return len <= UINT8_MAX ? 2 : len <= UINT16_MAX ? 3 : 5;
+		}
+
+		static std::size_t container_size(std::size_t count)
+		{
+			if (count > UINT32_MAX) throw fail("container too large for msgpack");
+			return count < 16 ? 1 : count <= UINT16_MAX ? 3 : 5;
+		}
+
+		// fixarray or fixmap below 16, otherwise the 16 or 32 bit form that follows id16
+		static char* put_head(char* out, std::size_t count, uint8_t fix, uint8_t id16)
+		{
+			if (count < 16) { *out++ = static_cast<char>(fix | count); return out; }
+			if (count <= UINT16_MAX) { *out++ = static_cast<char>(id16); return put_uint(out, static_cast<uint16_t>(count)); }
+			*out++ = static_cast<char>(id16 + 1);
+			return put_uint(out, static_cast<uint32_t>(count));
+		}
+
+		static char* put_string(char* out, char const* str, std::size_t len)
+		{
+			if      (len < 32)          { *out++ = static_cast<char>(0xa0 | len); }
+			else if (len <= UINT8_MAX)  { *out++ = static_cast<char>(0xd9); out = put_uint(out, static_cast<uint8_t>(len)); }
+			else if (len <= UINT16_MAX) { *out++ = static_cast<char>(0xda); out = put_uint(out, static_cast<uint16_t>(len)); }
+			else                        { *out++ = static_cast<char>(0xdb); out = put_uint(out, static_cast<uint32_t>(len)); }
+			return put(out, str, len);
+		}
+
+		static char* put_unsigned(char* out, uint64_t n)
+		{
+			if (n <= 0x7f)       { *out++ = static_cast<char>(n); return out; }
+			if (n <= UINT8_MAX)  { *out++ = static_cast<char>(0xcc); return put_uint(out, static_cast<uint8_t>(n)); }
+			if (n <= UINT16_MAX) { *out++ = static_cast<char>(0xcd); return put_uint(out, static_cast<uint16_t>(n)); }
+			if (n <= UINT32_MAX) { *out++ = static_cast<char>(0xce); return put_uint(out, static_cast<uint32_t>(n)); }
+			*out++ = static_cast<char>(0xcf);
+			return put_uint(out, n);
+		}
+
+		static char* put_integer(char* out, int64_t n)
+		{
+			if (n >= 0)         return put_unsigned(out, static_cast<uint64_t>(n));
+			if (n >= -32)       { *out++ = static_cast<char>(n); return out; }
+			if (n >= INT8_MIN)  { *out++ = static_cast<char>(0xd0); return put_uint(out, static_cast<uint8_t>(n)); }
+			if (n >= INT16_MIN) { *out++ = static_cast<char>(0xd1); return put_uint(out, static_cast<uint16_t>(n)); }
+			if (n >= INT32_MIN) { *out++ = static_cast<char>(0xd2); return put_uint(out, static_cast<uint32_t>(n)); }
+			*out++ = static_cast<char>(0xd3);
+			return put_uint(out, static_cast<uint64_t>(n));
+		}
+	};
+
+	struct cbor_writer : packed_writer
+	{
+		static std::size_t size(value const& root)
+		{
+			return value_size(root);
+		}
+
+		// out must have room for size(val) bytes, returns the end of the encoding
+		static char* write(value const& val, char* out)
+		{
+			switch (val.type)
+			{
+				case type::object:
+					out = put_head(out, 5, val.data.o->size());
+					for (auto const& it : val.data.o->object())
+					{
+						out = put_head(out, 3, it.first.size());
+						out = put(out, it.first.data(), it.first.size());
+						out = write(it.second, out);
+					}
+					return out;
+
+				case type::array:
+					out = put_head(out, 4, val.data.a->size());
+					for (auto const& element : *val.data.a) out = write(element, out);
+					return out;
+
+				case type::null:
+					*out++ = static_cast<char>(0xf6);
+					return out;
+
+				case type::boolean:
+					*out++ = static_cast<char>(val.data.b ? 0xf5 : 0xf4);
+					return out;
+
+				case type::n_double:
+					*out++ = static_cast<char>(fits_float(val.data.d) ? 0xfa : 0xfb);
+					return put_double(out, val.data.d);
+
+				case type::n_int32:  return put_integer(out, val.data.i);
+				case type::n_int64:  return put_integer(out, val.data.l);
+				case type::n_uint64: return put_head(out, 0, val.data.u);
+
+				case type::string:
+					out = put_head(out, 3, val.str_size());
+					return put(out, val.str_data(), val.str_size());
+
+				case type::binary:
+					out = put_head(out, 2, val.data.x->size());
+					return put(out, val.data.x->data(), val.data.x->size());
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+	private:
+
+		static std::size_t value_size(value const& val)
+		{
+			switch (val.type)
+			{
+				case type::object:
+				{
+					std::size_t size = head_size(val.data.o->size());
+					for (auto const& it : val.data.o->object())
+					{
+						size += head_size(it.first.size()) + it.first.size() + value_size(it.second);
+					}
+					return size;
+				}
+
+				case type::array:
+				{
+					std::size_t size = head_size(val.data.a->size());
+					for (auto const& element : *val.data.a) size += value_size(element);
+					return size;
+				}
+
+				case type::null:
+				case type::boolean:  return 1;
+				case type::n_double: return fits_float(val.data.d) ? 5 : 9;
+				case type::n_int32:  return head_size(negative_argument(val.data.i));
+				case type::n_int64:  return head_size(negative_argument(val.data.l));
+				case type::n_uint64: return head_size(val.data.u);
+				case type::string:   return head_size(val.str_size()) + val.str_size();
+				case type::binary:   return head_size(val.data.x->size()) + val.data.x->size();
+
+				default:
+					throw fail(std::string("unsupported type ") + type_string(val.type));
+			}
+		}
+
+		// negative integers are stored as -1 - n
+		static uint64_t negative_argument(int64_t n)
+		{
+			return n >= 0 ? static_cast<uint64_t>(n) : static_cast<uint64_t>(-(n + 1));
+		}
+
+		static std::size_t head_size(uint64_t arg)
+		{
+			return arg < 24 ? 1 : arg <= UINT8_MAX ? 2 : arg <= UINT16_MAX ? 3 : arg <= UINT32_MAX ? 5 : 9;
+		}
+
+		static char* put_head(char* out, uint8_t major, uint64_t arg)
+		{
+			char head = static_cast<char>(major << 5);
+			if (arg < 24)          { *out++ = static_cast<char>(head | arg); return out; }
+			if (arg <= UINT8_MAX)  { *out++ = static_cast<char>(head | 24); return put_uint(out, static_cast<uint8_t>(arg)); }
+			if (arg <= UINT16_MAX) { *out++ = static_cast<char>(head | 25); return put_uint(out, static_cast<uint16_t>(arg)); }
+			if (arg <= UINT32_MAX) { *out++ = static_cast<char>(head | 26); return put_uint(out, static_cast<uint32_t>(arg)); }
+			*out++ = static_cast<char>(head | 27);
+			return put_uint(out, arg);
+		}
+
+		static char* put_integer(char* out, int64_t n)
+		{
+			return put_head(out, n >= 0 ? 0 : 1, negative_argument(n));
+		}
+	};
+};
+
+// MARK: type conversion specializations
+template <> inline bool value::as<bool>() const
+{
+	return type == type::boolean ? data.b : false;
+}
+
+// A string borrowed from text parsed in situ is not zero terminated, so it has to be copied
+// first. That is a write, so on a const value it throws; as<string_ref>() never copies.
+template <> inline char const* value::as<char const*>() const
+{
+	if (type != type::string) return "";
+	if (str_borrowed()) throw fail("borrowed string is not zero terminated, use as<string_ref>()");
+	return str_data();
+}
+
+template <> inline char const* value::as<char const*>()
+{
+	return type == type::string ? str_terminated() : "";
+}
+
+template <> inline string_ref value::as<string_ref>() const
+{
+	return type == type::string ? string_ref(str_data(), str_size()) : string_ref();
+}
+
+template <> inline std::string value::as<std::string>() const
+{
+	return as<string_ref>();
+}
+
+// Short and borrowed strings have no std::string to refer to, so the first call moves them
+// to the heap. That is a write, so on a const value it throws for them instead;
+// as<string_ref>() works on both and never allocates.
+template <> inline std::string const& value::as<std::string const&>() const
+{
+	static std::string empty;
+	if (type != type::string) return empty;
+	if (!heap_string()) throw fail("string is not on the heap, use as<string_ref>()");
+	return *data.s;
+}
+
+template <> inline std::string const& value::as<std::string const&>()
+{
+	static std::string empty;
+	if (type != type::string) return empty;
+	move_to_heap();
+	return *data.s;
+}
+
+template <> inline bytes_t const& value::as<bytes_t const&>() const
+{
+	static bytes_t empty;
+	return type == type::binary ? *data.x : empty;
+}
+
+template <> inline bytes_t value::as<bytes_t>() const
+{
+	return as<bytes_t const&>();
+}
+
+static_assert(sizeof(value) == 16, "short strings rely on value being two words");
+
+// MARK: document
+// Parses into a tree whose strings and containers all come from one arena:
+// nodes are not freed one by one, and reusing the document reuses the memory.
+// Values taken out of the tree by move must not outlive the document; copies are independent.
+class document
+{
+public:
+
+	document() = default;
+	explicit document(std::size_t block_size) : m_arena(block_size) {}
+
+	document(document const&) = delete;
+	document& operator = (document const&) = delete;
+
+	value const& root() const { return m_root; }
+	value&       root()       { return m_root; }
+
+	bool from_string(char const* str, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::json_reader r(&m_arena, options);
+		return r.parse_string(str, m_root, errors);
+	}
+
+	// str[len] must still be the terminating zero
+	bool from_string(char const* str, std::size_t len, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::json_reader r(&m_arena, options);
+		return r.parse_string(str, m_root, errors, str + len + 1);
+	}
+
+	bool from_string(std::string const& str, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_string(str.c_str(), str.size(), errors, options);
+	}
+
+	bool from_json_file(char const* filename, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::json_reader r(&m_arena, options);
+		return r.parse_file(filename, m_root, errors);
+	}
+
+	bool from_bytes(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::bson_reader r(&m_arena, options);
+		return r.parse_data(data, size, m_root, errors);
+	}
+
+	bool from_bytes(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_bytes(data.data(), data.size(), errors, options);
+	}
+
+	bool from_msgpack(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::msgpack_reader r(&m_arena, options);
+		return r.parse_data(data, size, m_root, errors);
+	}
+
+	bool from_msgpack(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_msgpack(data.data(), data.size(), errors, options);
+	}
+
+	bool from_cbor(char const* data, size_t size, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::cbor_reader r(&m_arena, options);
+		return r.parse_data(data, size, m_root, errors);
+	}
+
+	bool from_cbor(bytes_t const& data, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		return from_cbor(data.data(), data.size(), errors, options);
+	}
+
+	bool from_bson_file(char const* filename, std::string* errors = nullptr, parse_options const& options = parse_options::global())
+	{
+		clear();
+		value::bson_reader r(&m_arena, options);
+		return r.parse_file(filename, m_root, errors);
+	}
+
+	void clear()
+	{
+		m_root = value();
+		m_arena.reset();
+	}
+
+private:
+
+	arena m_arena; // declared first, so it is destroyed after the tree
+	value m_root;
+};
+
+// MARK: paths
+// A JSON Pointer (RFC 6901) such as "/users/0/name", or "$.users[0].name" in the dotted
+// notation, split and hashed once so it can be evaluated again and again: against a tree,
+// or straight on JSON text and BSON bytes, skipping everything not on the way.
+// As in RFC 6901, a step like "0" picks an array element or the object key "0".
+class path
+{
+public:
+
+	explicit path(char const* str) { parse(str, str + strlen(str)); }
+	explicit path(std::string const& str) { parse(str.data(), str.data() + str.size()); }
+
+	std::size_t size() const { return m_steps.size(); }
+	bool empty() const { return m_steps.empty(); }
+
+	// nullptr if the path leads nowhere
+	value const* find(value const& root) const
+	{
+		value const* v = &root;
+		for (auto const& s : m_steps)
+		{
+			if (v->is_object())
+				v = v->data.o->lookup(key(s.name.data(), s.name.size(), s.hash));
+			else if (v->is_array() && v->data.a && s.index < v->data.a->size())
+				v = &(*v->data.a)[s.index];
+			else
+				return nullptr;
+			if (!v) return nullptr;
+		}
+		return v;
+	}
+
+	value* find(value& root) const { return const_cast<value*>(find(static_cast<value const&>(root))); }
+
+	// value::null() if the path leads nowhere
+	value const& operator () (value const& root) const
+	{
+		value const* v = find(root);
+		return v ? *v : value::null();
+	}
+
+	// false with errors left alone if the path leads nowhere, false with errors set if the data is invalid.
+	// The scan stops at the first match, so of duplicate keys the first one is found, while a parsed
+	// value keeps the last; find() and find_in_json() differ only for such text. Same for find_in_bson.
+	bool find_in_json(char const* json, value& result, std::string* errors = nullptr, parse_options const& options = parse_options::global()) const
+	{
+		value::json_reader r(nullptr, options);
+		return r.parse_path(json, m_steps, result, errors);
+	}
+
+	bool find_in_bson(char const* data, std::size_t size, value& result, std::string* errors = nullptr, parse_options const& options = parse_options::global()) const;
+
+	bool find_in_bson(bytes_t const& data, value& result, std::string* errors = nullptr, parse_options const& options = parse_options::global()) const
+	{
+		return find_in_bson(data.data(), data.size(), result, errors, options);
+	}
+
+private:
+
+	struct step
+	{
+		std::string name;
+		uint32_t    hash;
+		std::size_t index; // SIZE_MAX unless name is a canonical array index
+	};
+
+	std::vector<step> m_steps;
+
+	friend class cursor;
+	friend class bson_view;
+
+	void parse(char const* p, char const* end)
+	{
+		if (p == end) return; // the whole document
+		if (*p == '/')
+		{
+			while (p != end)
+			{
+				std::string name;
+				for (++p; p != end && *p != '/'; ++p)
+				{
+					if (*p != '~') name += *p;
+					else if (++p != end && (*p == '0' || *p == '1')) name += *p == '0' ? '~' : '/';
+					else throw fail("invalid escape in path");
+				}
+				add(std::move(name));
+			}
+		}
+		else if (*p == '$')
+		{
+			for (++p; p != end;)
+			{
+				std::string name;
+				if (*p == '.')
+				{
+					for (++p; p != end && *p != '.' && *p != '['; ++p) name += *p;
+					if (name.empty()) throw fail("empty name in path");
+				}
+				else if (*p == '[' && end - p > 1 && (p[1] == '\'' || p[1] == '"'))
+				{
+					char quote = p[1];
+					for (p += 2; p != end && *p != quote; ++p)
+					{
+						if (*p == '\\' && end - p > 1) ++p;
+						name += *p;
+					}
+					if (end - p < 2 || p[1] != ']') throw fail("unterminated name in path");
+					p += 2;
+				}
+				else if (*p == '[')
+				{
+					for (++p; p != end && *p >= '0' && *p <= '9'; ++p) name += *p;
+					if (name.empty() || p == end || *p != ']') throw fail("invalid index in path");
+					++p;
+				}
+				else
+				{
+					throw fail("expected '.' or '[' in path");
+				}
+				add(std::move(name));
+			}
+		}
+		else
+		{
+			throw fail("path must start with '/' or '$'");
+		}
+	}
+
+	void add(std::string&& name)
+	{
+		std::size_t index = name.empty() || name.size() > std::size_t(std::numeric_limits<std::size_t>::digits10) || (name[0] == '0' && name.size() > 1) ? SIZE_MAX : 0;
+		for (std::size_t i=0; i<name.size() && index != SIZE_MAX; ++i)
+		{
+			if (name[i] < '0' || name[i] > '9') index = SIZE_MAX;
+			else index = index * 10 + (name[i] - '0');
+		}
+		uint32_t h = key_hash(name.data(), name.size());
+		m_steps.push_back(step{ std::move(name), h, index });
+	}
+};
+
+// MARK: cursors
+// On-demand access to JSON text. A cursor is a position in the text: moving to a child skips
+// the siblings before it by matching brackets, and nothing is parsed until get() asks for it.
+// The text must stay alive and unchanged while cursors point into it. Every lookup scans its
+// container from the start, so walk long arrays with begin()/end() rather than by index.
+// A missing child, a move past the end and malformed text all give a cursor that doesn't exist.
+// A key that appears twice gives the first occurrence; a parsed value keeps the last.
+class cursor
+{
+public:
+
+	class iterator;
+
+	cursor() = default;
+	explicit cursor(char const* text) : cursor(text, text ? strlen(text) : 0) {}
+	explicit cursor(std::string const& text) : cursor(text.c_str(), text.size()) {}
+	cursor(std::string&&) = delete; // would point into a temporary
+
+	// text[length] must still be the terminating zero; knowing the length saves a pass over the text
+	cursor(char const* text, std::size_t length) : m_at(text), m_limit(text ? text + length + 1 : nullptr)
+	{
+		if (m_at && value::scanner::is_space(*m_at)) m_at = value::scanner::skip_spaces(m_at, m_limit, m_line);
+		if (m_at && !*m_at) m_at = nullptr;
+	}
+
+	bool exists()     const { return m_at != nullptr; }
+	bool is_null()    const { return peek() == 'n'; }
+	bool is_boolean() const { return peek() == 't' || peek() == 'f'; }
+	bool is_number()  const { return peek() == '-' || (peek() >= '0' && peek() <= '9'); }
+	bool is_string()  const { return peek() == '"'; }
+	bool is_array()   const { return peek() == '['; }
+	bool is_object()  const { return peek() == '{'; }
+
+	cursor operator () (json::key const& k)   const { return child(string_ref(k.data(), k.size()), SIZE_MAX); }
+	cursor operator () (std::string const& k) const { return child(string_ref(k.data(), k.size()), SIZE_MAX); }
+	cursor operator () (char const* k)        const { return child(string_ref(k, strlen(k)), SIZE_MAX); }
+	cursor operator [] (std::size_t index)    const { return child(string_ref(), index); }
+
+	cursor operator () (path const& p) const
+	{
+		cursor c = *this;
+		for (auto const& s : p.m_steps)
+		{
+			if (!c.is_object() && !c.is_array()) return cursor();
+			value::json_reader r;
+			if (!r.seek_child(c.m_at, c.m_line, c.m_key, m_limit, s)) return cursor();
+		}
+		return c;
+	}
+
+	// children of an array or object in order, members of an object tell their key()
+	iterator begin() const;
+	iterator end() const;
+
+	// the following child of the same container
+	cursor next() const
+	{
+		cursor c = *this;
+		value::json_reader r;
+		if (!m_at || !r.seek_next(c.m_at, c.m_line, c.m_key, m_limit)) c = cursor();
+		return c;
+	}
+
+	// empty for array elements and the root
+	std::string key() const
+	{
+		std::string result;
+		value::json_reader r;
+		if (m_key) r.read_key(m_key, m_line, m_limit, result);
+		return result;
+	}
+
+	// the text of the value, brackets included
+	string_ref raw() const
+	{
+		char const* end = nullptr;
+		value::json_reader r;
+		return m_at && r.seek_end(m_at, m_line, m_limit, end) ? string_ref(m_at, end - m_at) : string_ref();
+	}
+
+	bool get(value& result, std::string* errors = nullptr) const
+	{
+		if (!m_at)
+		{
+			if (errors) *errors = "no value";
+			result = value();
+			return false;
+		}
+		value::json_reader r;
+		return r.parse_at(m_at, m_line, m_limit, result, errors);
+	}
+
+	value get() const
+	{
+		value result;
+		get(result);
+		return result;
+	}
+
+	// the value is a temporary, so only types that own their data can come out of it
+	template <typename T> T as() const
+	{
+		static_assert(!std::is_reference<T>::value, "would refer to a temporary");
+		static_assert(!std::is_pointer<T>::value && !std::is_same<T, string_ref>::value, "would point into a temporary");
+		return get().as<T>();
+	}
+
+private:
+
+	struct step
+	{
+		string_ref  name;
+		std::size_t index;
+	};
+
+	char const* m_at    = nullptr;
+	char const* m_key   = nullptr; // the pair this is the value of
+	char const* m_limit = nullptr; // just past the terminating zero of the text
+	std::size_t m_line  = 1;
+
+	char peek() const { return m_at ? *m_at : '\0'; }
+
+	cursor child(string_ref name, std::size_t index) const
+	{
+		cursor c = *this;
+		value::json_reader r;
+		if (!(is_object() || is_array()) || !r.seek_child(c.m_at, c.m_line, c.m_key, m_limit, step{ name, index })) c = cursor();
+		return c;
+	}
+};
+
+class cursor::iterator
+{
+public:
+
+	cursor const& operator *  () const { return m_cursor; }
+	cursor const* operator -> () const { return &m_cursor; }
+	iterator& operator ++ () { m_cursor = m_cursor.next(); return *this; }
+	bool operator == (iterator const& other) const { return m_cursor.m_at == other.m_cursor.m_at; }
+	bool operator != (iterator const& other) const { return m_cursor.m_at != other.m_cursor.m_at; }
+
+private:
+
+	friend class cursor;
+	explicit iterator(cursor const& c) : m_cursor(c) {}
+	cursor m_cursor;
+};
+
+inline cursor::iterator cursor::begin() const
+{
+	cursor c = *this;
+	value::json_reader r;
+	if (!(is_object() || is_array()) || !r.seek_first(c.m_at, c.m_line, c.m_key, c.m_limit)) c = cursor();
+	return iterator(c);
+}
+
+inline cursor::iterator cursor::end() const { return iterator(cursor()); }
+
+// MARK: bson views
+// Read-only access to BSON bytes where they are. Each view is one element: lookups and
+// iteration walk the elements in place and skip subdocuments by their length prefix, and
+// nothing is allocated unless get() builds a value. Every length is checked against the
+// enclosing document, so damaged data ends the walk instead of reading past it.
+// The bytes must stay alive while views point into them. Like cursors, lookups stop at the
+// first of duplicate keys, where from_bytes() keeps the last.
+class bson_view
+{
+public:
+
+	class iterator;
+
+	bson_view() = default;
+	bson_view(char const* data, std::size_t size)
+	{
+		int32_t length;
+		if (!data || size < 5) return;
+		memcpy(&length, data, sizeof(length));
+		if (length < 5 || static_cast<std::size_t>(length) > size || data[length - 1] != 0) return;
+		m_value = data;
+		m_end   = data + length;
+		m_limit = m_end;
+		m_type  = value::bson_document;
+	}
+	explicit bson_view(bytes_t const& data) : bson_view(data.data(), data.size()) {}
+
+	bool exists()     const { return m_value != nullptr; }
+	bool is_null()    const { return m_type == value::bson_null; }
+	bool is_boolean() const { return m_type == value::bson_bool; }
+	bool is_number()  const { return m_type == value::bson_double || m_type == value::bson_int32 || m_type == value::bson_int64 || m_type == value::bson_utc_time; }
+	bool is_string()  const { return m_type == value::bson_string; }
+	bool is_binary()  const { return m_type == value::bson_binary; }
+	bool is_array()   const { return m_type == value::bson_array; }
+	bool is_object()  const { return m_type == value::bson_document; }
+
+	// the element's name, empty for the outermost document
+	string_ref key() const { return m_element ? string_ref(m_element + 1, m_value - m_element - 2) : string_ref(); }
+
+	bson_view operator () (json::key const& k)   const { return find(k.data(), k.size()); }
+	bson_view operator () (std::string const& k) const { return find(k.data(), k.size()); }
+	bson_view operator () (char const* k)        const { return find(k, strlen(k)); }
+
+	// arrays are taken in order, their "0", "1", ... names are not checked
+	bson_view operator [] (std::size_t index) const
+	{
+		bson_view v = is_array() ? first() : bson_view();
+		for (; v.exists() && index; --index) v = v.next();
+		return v;
+	}
+
+	bson_view operator () (path const& p) const
+	{
+		bson_view v = *this;
+		for (auto const& s : p.m_steps)
+		{
+			if      (v.is_object()) v = v.find(s.name.data(), s.name.size());
+			else if (v.is_array())  v = v[s.index];
+			else return bson_view();
+		}
+		return v;
+	}
+
+	// the elements of a document or array in order
+	iterator begin() const;
+	iterator end() const;
+
+	// the following element of the same document
+	bson_view next() const { return m_element ? element(m_end, m_limit) : bson_view(); }
+
+	bool get(value& result, std::string* errors = nullptr, parse_options const& options = parse_options::global()) const
+	{
+		if (!m_value)
+		{
+			if (errors) *errors = "no value";
+			result = value();
+			return false;
+		}
+		value::bson_reader r(nullptr, options);
+		return r.parse_value(m_type, m_value, m_end, result, errors);
+	}
+
+	value get() const
+	{
+		value result;
+		get(result);
+		return result;
+	}
+
+	// long strings are read in place, so apart from containers and binary data this doesn't allocate
+	template <typename T> T as() const
+	{
+		static_assert(!std::is_reference<T>::value, "would refer to a temporary");
+		parse_options options;
+		options.in_situ = true;
+		value result;
+		get(result, nullptr, options);
+		return result.as<T>();
+	}
+
+private:
+
+	char const* m_element = nullptr; // the type byte, nullptr for the outermost document
+	char const* m_value   = nullptr;
+	char const* m_end     = nullptr; // end of the value
+	char const* m_limit   = nullptr; // end of the elements around this one
+	uint8_t     m_type    = 0;
+
+	bson_view first() const
+	{
+		return is_object() || is_array() ? element(m_value + 4, m_end - 1) : bson_view();
+	}
+
+	bson_view find(char const* name, std::size_t len) const
+	{
+		bson_view v = is_object() ? first() : bson_view();
+		while (v.exists() && !(static_cast<std::size_t>(v.m_value - v.m_element - 2) == len && memcmp(v.m_element + 1, name, len) == 0))
+		{
+			v = v.next();
+		}
+		return v;
+	}
+
+	// the element at p, which must end by limit
+	static bson_view element(char const* p, char const* limit)
+	{
+		bson_view v;
+		if (p >= limit || *p == 0) return v;
+		char const* name = p + 1;
+		char const* terminator = static_cast<char const*>(memchr(name, 0, limit - name));
+		if (!terminator) return v;
+		char const* data = terminator + 1;
+		std::size_t size = value_size(static_cast<uint8_t>(*p), data, limit);
+		if (size == SIZE_MAX) return v;
+		v.m_element = p;
+		v.m_value   = data;
+		v.m_end     = data + size;
+		v.m_limit   = limit;
+		v.m_type    = static_cast<uint8_t>(*p);
+		return v;
+	}
+
+	// SIZE_MAX if the type is unknown or the value doesn't fit
+	static std::size_t value_size(uint8_t type, char const* data, char const* limit)
+	{
+		std::size_t available = limit - data;
+		std::size_t size = SIZE_MAX;
+		int32_t length = 0;
+		if (available >= 4) memcpy(&length, data, sizeof(length));
+		switch (type)
+		{
+			case value::bson_double:
+			case value::bson_int64:
+			case value::bson_utc_time: size = 8; break;
+			case value::bson_int32:    size = 4; break;
+			case value::bson_bool:     size = 1; break;
+			case value::bson_null:     size = 0; break;
+			case value::bson_string:   if (available >= 4 && length > 0) size = 4 + static_cast<std::size_t>(length); break;
+			case value::bson_binary:   if (available >= 4 && length >= 0) size = 5 + static_cast<std::size_t>(length); break;
+			case value::bson_document:
+			case value::bson_array:    if (available >= 4 && length >= 5) size = static_cast<std::size_t>(length); break;
+			default: break;
+		}
+		if (size > available) return SIZE_MAX;
+		if ((type == value::bson_string || type == value::bson_document || type == value::bson_array) && data[size - 1] != 0) return SIZE_MAX;
+		return size;
+	}
+};
+
+class bson_view::iterator
+{
+public:
+
+	bson_view const& operator *  () const { return m_view; }
+	bson_view const* operator -> () const { return &m_view; }
+	iterator& operator ++ () { m_view = m_view.next(); return *this; }
+	bool operator == (iterator const& other) const { return m_view.m_value == other.m_view.m_value; }
+	bool operator != (iterator const& other) const { return m_view.m_value != other.m_view.m_value; }
+
+private:
+
+	friend class bson_view;
+	explicit iterator(bson_view const& v) : m_view(v) {}
+	bson_view m_view;
+};
+
+inline bson_view::iterator bson_view::begin() const { return iterator(first()); }
+inline bson_view::iterator bson_view::end() const { return iterator(bson_view()); }
+
+template <> inline string_ref bson_view::as<string_ref>() const
+{
+	return is_string() ? string_ref(m_value + 4, m_end - m_value - 5) : string_ref();
+}
+
+template <> inline char const* bson_view::as<char const*>() const
+{
+	return is_string() ? m_value + 4 : "";
+}
+
+// false with errors left alone if the path leads nowhere, false with errors set if the data is invalid
+inline bool path::find_in_bson(char const* data, std::size_t size, value& result, std::string* errors, parse_options const& options) const
+{
+	result = value();
+	bson_view root(data, size);
+	if (!root.exists())
+	{
+		if (errors) *errors = "invalid document";
+		return false;
+	}
+	bson_view found = root(*this);
+	return found.exists() && found.get(result, errors, options);
+}
+
+// MARK: bson streams
+// Documents stored back to back, as in mongodump files and append-only logs, framed by their
+// length prefixes. Input is a buffer, a mapped file or a std::istream; views into a buffer or
+// file stay valid with it, views read from a stream only until the next call.
+// decode() can hand documents to worker threads and still delivers them in order.
+class bson_stream
+{
+public:
+
+	bson_stream() = default;
+	bson_stream(char const* data, std::size_t size) : m_data(data), m_size(size) {}
+	explicit bson_stream(bytes_t const& data) : bson_stream(data.data(), data.size()) {}
+	explicit bson_stream(std::istream& in) : m_in(&in) {}
+
+	bool open_file(char const* filename)
+	{
+		m_file.reset(new value::file_view(filename));
+		m_in     = nullptr;
+		m_data   = m_file->data();
+		m_size   = m_file->size();
+		m_offset = 0;
+		m_errors.clear();
+		if (!m_file->is_open()) m_errors = "failed to load file '" + std::string(filename) + "'";
+		return m_errors.empty();
+	}
+
+	// Longer documents from a stream count as damaged. The default is MongoDB's limit.
+	void set_max_size(std::size_t size) { m_max_size = size; }
+
+	// how far the documents read so far reach
+	std::size_t offset() const { return m_offset; }
+	std::string const& errors() const { return m_errors; }
+
+	// a view that doesn't exist at the end of the input, and also with errors() set if a document is damaged
+	bson_view next()
+	{
+		if (!m_errors.empty()) return bson_view();
+
+		int32_t length;
+		if (m_in)
+		{
+			char header[4];
+			m_in->read(header, sizeof(header));
+			if (m_in->gcount() == 0) return bson_view();
+			memcpy(&length, header, sizeof(length));
+			if (m_in->gcount() != sizeof(header) || length < 5 || static_cast<std::size_t>(length) > m_max_size) return damaged();
+
+			// the buffer grows at most twice the bytes that arrived, so a damaged length can't allocate much
+			m_buffer.resize(sizeof(header));
+			memcpy(m_buffer.data(), header, sizeof(header));
+			while (m_buffer.size() < static_cast<std::size_t>(length))
+			{
+				std::size_t have  = m_buffer.size();
+				std::size_t piece = std::min<std::size_t>(length - have, std::max<std::size_t>(have, 4096));
+				m_buffer.resize(have + piece);
+				m_in->read(m_buffer.data() + have, piece);
+				if (m_in->gcount() != static_cast<std::streamsize>(piece)) return damaged();
+			}
+			bson_view document(m_buffer.data(), m_buffer.size());
+			if (!document.exists()) return damaged();
+			m_offset += length;
+			return document;
+		}
+
+		if (m_offset == m_size) return bson_view();
+		bson_view document(m_data + m_offset, m_size - m_offset);
+		if (!document.exists()) return damaged();
+		memcpy(&length, m_data + m_offset, sizeof(length));
+		m_offset += length;
+		return document;
+	}
+
+	// Decodes the remaining documents and calls handler(value&) with each in order; returning
+	// false stops. With more than one thread (0 for one per core) workers decode at most a few
+	// documents ahead of the handler, which runs on the calling thread.
+	// Returns true once the input is used up, otherwise errors() says why it stopped.
+	template <typename Handler> bool decode(Handler handler, unsigned threads = 1, parse_options const& options = parse_options::global())
+	{
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+		if (threads <= 1)
+		{
+			value result;
+			for (bson_view document = next(); document.exists(); document = next())
+			{
+				if (!document.get(result, &m_errors, options)) return false;
+				if (!handler(result))
+				{
+					m_errors = "stopped by handler";
+					return false;
+				}
+			}
+			return m_errors.empty();
+		}
+
+		// documents go to the workers in batches, so the locking is paid per batch
+		struct slot
+		{
+			bytes_t                  copy; // stream input, whose own buffer is reused for the next document
+			std::vector<std::size_t> ends;
+			std::vector<bson_view>   inputs;
+			std::vector<value>       results;
+			std::size_t              decoded = 0;
+			std::string              error;
+			std::string              damage; // the input is damaged right after this batch
+			bool                     done = false;
+		};
+
+		std::size_t window = threads * 4;
+		std::vector<slot> slots(window);
+
+		std::mutex              mutex;
+		std::condition_variable changed;
+		std::size_t             produced = 0;
+		std::size_t             taken    = 0;
+		bool                    finished = false;
+
+		auto work = [&]
+		{
+			for (;;)
+			{
+				std::size_t i;
 				{
-					write<uint8_t>(bson_array);
-					write_string(key);
-					size_t beg = data.size();
-					write<uint32_t>(0); // len
-					for (size_t i=0; i<val.size(); ++i)
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [&] { return finished || taken < produced; });
+					if (taken == produced) return;
+					i = taken++;
+				}
+
+				slot& s = slots[i % window];
+				s.results.resize(s.inputs.size()); // the previous batch is released here, off the handler's thread
+				s.decoded = 0;
+				while (s.decoded < s.inputs.size() && s.inputs[s.decoded].get(s.results[s.decoded], &s.error, options)) ++s.decoded;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				s.done = true;
+				changed.notify_all();
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned t = 0; t < threads; ++t) pool.emplace_back(work);
+
+		std::exception_ptr failure; // from the handler, rethrown once the workers are stopped
+		for (std::size_t consumed = 0; m_errors.empty() && !failure; ++consumed)
+		{
+			// a slot is refilled only once the handler is done with it
+			while (!finished && produced < consumed + window)
+			{
+				slot& s = slots[produced % window];
+				s.copy.clear();
+				s.ends.clear();
+				s.inputs.clear();
+				s.error.clear();
+				s.damage.clear();
+				std::size_t start = m_offset;
+				while (m_offset - start < batch_bytes)
+				{
+					bson_view document = next();
+					if (!document.exists()) break;
+					if (m_in)
 					{
-						write_value(std::to_string(i).c_str(), val[i]);
+						s.copy.insert(s.copy.end(), m_buffer.begin(), m_buffer.end());
+						s.ends.push_back(s.copy.size());
 					}
-					write<uint8_t>(0x00);
-					uint32_t len = data.size() - beg;
-					write_at(beg, len);
-					break;
+					s.inputs.push_back(document);
 				}
-				
-				case type::n_double:
-					write<uint8_t>(bson_double);
-					write_string(key);
-					write(val.data.d);
-					break;
-				
-				case type::n_int32:
-					write<uint8_t>(bson_int32);
-					write_string(key);
-					write(val.data.i);
-					break;
-				
-				case type::n_int64:
-					write<uint8_t>(bson_int64);
-					write_string(key);
-					write(val.data.l);
-					break;
-				
-				case type::boolean:
-					write<uint8_t>(bson_bool);
-					write_string(key);
-					write<uint8_t>(val.data.b ? 1 : 0);
-					break;
-				
-				case type::string:
-					write<uint8_t>(bson_string);
-					write_string(key);
-					write<uint32_t>(val.data.s->length() + 1);
-					write_string(val.data.s->c_str());
-					break;
-				
-				case type::binary:
-					write<uint8_t>(bson_binary);
-					write_string(key);
-					write<int32_t>(val.data.x->size());
-					write<uint8_t>(0x00); // subtype
-					write(val.data.x->data(), val.data.x->size());
-					break;
-				
-				case type::null:
-					write<uint8_t>(bson_null);
-					write_string(key);
-					break;
-				
-				default:
-					throw fail(std::string("unsupported type ") + type_string(val.type));
-					break;
+				for (std::size_t k = 0; k < s.ends.size(); ++k) // the copy has stopped moving
+				{
+					std::size_t begin = k ? s.ends[k - 1] : 0;
+					s.inputs[k] = bson_view(s.copy.data() + begin, s.ends[k] - begin);
+				}
+
+				s.damage.swap(m_errors); // reported once the documents before it are delivered
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!s.inputs.empty() || !s.damage.empty())
+				{
+					s.done = false;
+					++produced;
+				}
+				finished = s.inputs.empty() || !s.damage.empty();
+				changed.notify_all();
 			}
+			if (consumed == produced) break;
+
+			slot& s = slots[consumed % window];
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] { return s.done; });
+			}
+			try
+			{
+				for (std::size_t k = 0; k < s.decoded && m_errors.empty(); ++k)
+					if (!handler(s.results[k])) m_errors = "stopped by handler";
+			}
+			catch (...)
+			{
+				failure = std::current_exception();
+			}
+			if (m_errors.empty()) m_errors = !s.error.empty() ? s.error : s.damage;
 		}
-		
-		void write(void const* ptr, size_t size)
+
 		{
-			char const* src = static_cast<char const*>(ptr);
-			data.insert(data.end(), src, src + size);
+			std::lock_guard<std::mutex> lock(mutex);
+			finished = true;
+			taken = produced; // documents not started yet are dropped
+			changed.notify_all();
 		}
-		
-		template <typename T> void write(T const& t) { write(&t, sizeof(T)); }
-		void write_string(char const* str) { write(str, strlen(str) + 1); }
-		void write_at(size_t at, uint32_t val) { *((uint32_t*)(data.data() + at)) = val; }
-	};
+		for (auto& t : pool) t.join();
+		if (failure) std::rethrow_exception(failure);
+		return m_errors.empty();
+	}
+
+private:
+
+	char const*                       m_data   = nullptr;
+	std::size_t                       m_size   = 0;
+	std::size_t                       m_offset = 0;
+	std::istream*                     m_in     = nullptr;
+	std::unique_ptr<value::file_view> m_file;
+	bytes_t                           m_buffer;
+	std::string                       m_errors;
+	std::size_t                       m_max_size = 16 * 1024 * 1024;
+
+	static constexpr std::size_t batch_bytes = 65536;
+
+	bson_view damaged()
+	{
+		m_errors = "damaged document at offset " + std::to_string(m_offset);
+		return bson_view();
+	}
 };
 
-// MARK: type conversion specializations
-template <> inline bool value::as<bool>() const
+// MARK: sax
+// Handlers are matched at compile time, so deriving from sax_handler and hiding only the
+// events of interest is enough. Returning false stops the parse.
+// Strings and keys point into parser memory and are only valid during the call.
+struct sax_handler
 {
-	return type == type::boolean ? data.b : false;
-}
+	bool null()                     { return true; }
+	bool boolean(bool)              { return true; }
+	bool number(value const&)       { return true; }
+	bool string(string_ref const&)  { return true; }
+	bool key(string_ref const&)     { return true; }
+	bool start_object()             { return true; }
+	bool end_object()               { return true; }
+	bool start_array()              { return true; }
+	bool end_array()                { return true; }
+};
 
-template <> inline char const* value::as<char const*>() const
+template <typename Handler> bool sax_parse(char const* str, Handler& handler, std::string* errors)
 {
-	return type == type::string ? data.s->c_str() : "";
+	value::json_reader r;
+	return r.parse_events(str, handler, errors);
 }
 
-template <> inline std::string value::as<std::string>() const
+// builds a tree from events, so sax_parse and push_parser can produce values too
+class value_builder : public sax_handler
 {
-	return as<char const*>();
-}
+public:
 
-template <> inline std::string const& value::as<std::string const&>() const
-{
-	static std::string empty;
-	return type == type::string ? *data.s : empty;
-}
+	value const& result() const { return m_root; }
+	value&       result()       { return m_root; }
 
-template <> inline bytes_t const& value::as<bytes_t const&>() const
-{
-	static bytes_t empty;
-	return type == type::binary ? *data.x : empty;
-}
+	bool null()                      { put(value());   return true; }
+	bool boolean(bool b)             { put(value(b));  return true; }
+	bool number(value const& n)      { put(value(n));  return true; }
+	bool string(string_ref const& s) { put(value(s));  return true; }
+	bool key(string_ref const& k)    { m_key.assign(k.data(), k.size()); return true; }
+	bool start_object()              { m_stack.push_back(&put(value(type::object))); return true; }
+	bool end_object()                { m_stack.pop_back(); return true; }
+	bool start_array()               { m_stack.push_back(&put(value(type::array)));  return true; }
+	bool end_array()                 { m_stack.pop_back(); return true; }
 
-template <> inline bytes_t value::as<bytes_t>() const
+private:
+
+	// open containers only ever grow at their last child, so the pointers stay valid
+	value& put(value&& v)
+	{
+		if (m_stack.empty()) return m_root = std::move(v);
+		value& parent = *m_stack.back();
+		return parent.is_array() ? parent.append(std::move(v)) : (parent(m_key) = std::move(v));
+	}
+
+	value               m_root;
+	std::vector<value*> m_stack;
+	std::string         m_key;
+};
+
+// MARK: push parser
+// Takes the document in chunks split at any byte and reports the same events as sax_parse.
+// Structure is tracked here, tokens go through json_reader once they are complete; only a
+// token that straddles chunks is copied, so memory is bounded by the longest string or number.
+template <typename Handler> class push_parser
 {
-	return as<bytes_t const&>();
-}
+public:
+
+	explicit push_parser(Handler& handler) : m_handler(handler) {}
+
+	// false once the input is known to be invalid or the handler stopped, see errors()
+	bool feed(char const* data, std::size_t size)
+	{
+		char const* p = data;
+		m_end = data + size;
+		if (m_token != token::none && p != m_end && !m_failed)
+		{
+			m_begin = p;
+			p = scan_token(p, m_end);
+		}
+
+		while (p != m_end && !m_failed)
+		{
+			char c = *p;
+			if (value::scanner::is_space(c))
+			{
+				if (c == '\n') ++m_line;
+				++p;
+				continue;
+			}
+
+			switch (m_state)
+			{
+				case state::value:
+					if      (c == '{' || c == '[')     open(c);
+					else if (c == ']' && top() == '[') close(c);
+					else if (c == '"') { p = begin_token(token::string, false, p); continue; }
+					else if (c != '}') { p = begin_token(token::bare,   false, p); continue; }
+					else fail("unexpected '}'");
+					break;
+
+				case state::key:
+					if      (c == '"') { p = begin_token(token::string, true, p); continue; }
+					else if (c == '}') close(c);
+					else fail("expected quoted pair key");
+					break;
+
+				case state::colon:
+					if (c == ':') m_state = state::value;
+					else fail("expected ':' after pair key");
+					break;
+
+				case state::comma:
+					if      (c == ',') m_state = top() == '{' ? state::key : state::value;
+					else if (c == (top() == '{' ? '}' : ']')) close(c);
+					else fail(top() == '{' ? "missing comma in object" : "missing comma in array");
+					break;
+
+				case state::done:
+					fail("unexpected data after document");
+					break;
+			}
+			++p;
+		}
+		return !m_failed;
+	}
+
+	// call after the last chunk: a number ending the input only completes here
+	bool finish()
+	{
+		if (!m_failed && m_token == token::bare) complete(m_buf.data(), m_buf.data() + m_buf.size());
+		if (!m_failed && m_state != state::done) fail("unexpected end of document");
+		return !m_failed;
+	}
+
+	bool done() const { return m_state == state::done; }
+	std::string const& errors() const { return m_errors; }
+
+private:
+
+	enum class state { value, key, colon, comma, done };
+	enum class token { none, string, bare };
+
+	char top() const { return m_stack.empty() ? '\0' : m_stack.back(); }
+
+	void open(char c)
+	{
+		m_stack.push_back(c);
+		emit(c == '{' ? m_handler.start_object() : m_handler.start_array());
+		m_state = c == '{' ? state::key : state::value;
+	}
+
+	void close(char c)
+	{
+		m_stack.pop_back();
+		emit(c == '}' ? m_handler.end_object() : m_handler.end_array());
+		after_value();
+	}
+
+	void after_value() { m_state = m_stack.empty() ? state::done : state::comma; }
+
+	char const* begin_token(token kind, bool is_key, char const* p)
+	{
+		m_token  = kind;
+		m_is_key = is_key;
+		m_escape = false;
+		m_begin  = p;
+		return scan_token(kind == token::string ? p + 1 : p, m_end);
+	}
+
+	// looks for the end of the current token, buffering what this chunk holds of it
+	char const* scan_token(char const* p, char const* end)
+	{
+		if (m_token == token::string)
+		{
+			for (; p != end; ++p)
+			{
+				if      (m_escape)    m_escape = false;
+				else if (*p == '\\') m_escape = true;
+				else if (*p == '"')   break;
+			}
+			if (p != end) ++p; // past the closing quote
+			else { m_buf.append(m_begin, end); return end; }
+		}
+		else
+		{
+			while (p != end && !is_delimiter(*p)) ++p;
+			if (p == end) { m_buf.append(m_begin, end); return end; }
+		}
+
+		// a token inside one chunk is read in place, it ends before the chunk does
+		if (m_buf.empty()) complete(m_begin, p);
+		else
+		{
+			m_buf.append(m_begin, p);
+			complete(m_buf.data(), m_buf.data() + m_buf.size());
+		}
+		return p;
+	}
+
+	static bool is_delimiter(char c)
+	{
+		return value::scanner::is_space(c) || c == ',' || c == ':' || c == ']' || c == '}' || c == '[' || c == '{' || c == '"';
+	}
+
+	void complete(char const* begin, char const* end)
+	{
+		std::string errors;
+		if (m_reader.parse_token(begin, end, m_is_key, m_line, m_handler, &errors))
+		{
+			if (m_is_key) m_state = state::colon;
+			else after_value();
+		}
+		else
+		{
+			m_failed = true;
+			m_errors = errors;
+		}
+		m_token = token::none;
+		m_buf.clear();
+	}
+
+	void emit(bool go) { if (!go) { m_failed = true; m_errors = "stopped by handler"; } }
+
+	void fail(char const* what)
+	{
+		std::ostringstream oss;
+		oss << what << " at line " << m_line;
+		m_errors = oss.str();
+		m_failed = true;
+	}
+
+	Handler&           m_handler;
+	value::json_reader m_reader;
+	std::vector<char>  m_stack;
+	std::string        m_buf;    // start of a token continued in the next chunk
+	std::string        m_errors;
+	char const*        m_begin  = nullptr;
+	char const*        m_end    = nullptr;
+	std::size_t        m_line   = 1;
+	state              m_state  = state::value;
+	token              m_token  = token::none;
+	bool               m_is_key = false;
+	bool               m_escape = false;
+	bool               m_failed = false;
+};
 
 }
@@ -1,13 +1,14 @@
 #include <sstream>
 #include <iostream>
+#include <atomic>
 #include "tests.hpp"
 
 #define TEST_LEAKS 1
 
 #if TEST_LEAKS == 1
 
-static long g_allocs = 0;
-static long g_total_allocs = 0;
+static std::atomic<long> g_allocs(0); // parsing may allocate on several threads
+static std::atomic<long> g_total_allocs(0);
 
 void* operator new(size_t size)
 {
@@ -59,16 +60,6 @@ template <typename T, typename U> void compare_check(T const& a, U const& b)
 template <typename U> void compare_check(char a, U const& b)          { compare_check(a + 0, b); }
 template <typename U> void compare_check(unsigned char a, U const& b) { compare_check(a + 0, b); }
 
-void compare_check(char const* a, std::string* b)
-{
-	return compare_check(a, *b);
-}
-
-void compare_check(std::string const& a, std::string* b)
-{
-	return compare_check(a, *b);
-}
-
 void run_tests()
 {
 	std::cout << "sizeof(json::value) = " << sizeof(json::value) << " bytes" << std::endl << std::endl;
@@ -79,24 +70,24 @@ void run_tests()
 	TYPE var = VALUE; \
 	json::value val(var); \
 	print_padded(#TYPE, 20); \
-	compare_check(var, val.data.FIELD); \
+	compare_check(var, val.FIELD); \
 	std::cout << " -> " << json::type_string(val.type) << std::endl; \
 }
-	CONSTRUCT(char,               -123,     i);
-	CONSTRUCT(unsigned char,       123,     i);
-	CONSTRUCT(short,              -123,     i);
-	CONSTRUCT(unsigned short,      123,     i);
-	CONSTRUCT(int,                -123,     i);
-	CONSTRUCT(unsigned int,        123,     u);
-	CONSTRUCT(long,               -123,     l);
-	CONSTRUCT(unsigned long,       123,     u);
-	CONSTRUCT(long long,          -123,     l);
-	CONSTRUCT(unsigned long long,  123,     u);
-	CONSTRUCT(float,              -123.456, d);
-	CONSTRUCT(double,             -123.456, d);
-	CONSTRUCT(char const*,        "text",   s);
-	CONSTRUCT(std::string,        "text",   s);
-	CONSTRUCT(bool,               true,     b);
+	CONSTRUCT(char,               -123,     data.i);
+	CONSTRUCT(unsigned char,       123,     data.i);
+	CONSTRUCT(short,              -123,     data.i);
+	CONSTRUCT(unsigned short,      123,     data.i);
+	CONSTRUCT(int,                -123,     data.i);
+	CONSTRUCT(unsigned int,        123,     data.u);
+	CONSTRUCT(long,               -123,     data.l);
+	CONSTRUCT(unsigned long,       123,     data.u);
+	CONSTRUCT(long long,          -123,     data.l);
+	CONSTRUCT(unsigned long long,  123,     data.u);
+	CONSTRUCT(float,              -123.456, data.d);
+	CONSTRUCT(double,             -123.456, data.d);
+	CONSTRUCT(char const*,        "text",   str_data());
+	CONSTRUCT(std::string,        "text",   str_data());
+	CONSTRUCT(bool,               true,     data.b);
 	
 	std::cout << "\n***** assignment *****\n";
 #define ASSIGN(TYPE, VALUE, FIELD) \
@@ -105,22 +96,22 @@ void run_tests()
 	json::value val; \
 	val = var; \
 	print_padded(#TYPE, 20); \
-	compare_check(var, val.data.FIELD); \
+	compare_check(var, val.FIELD); \
 	std::cout << std::endl; \
 }
-	ASSIGN(short,              -123,     i);
-	ASSIGN(unsigned short,      123,     i);
-	ASSIGN(int,                -123,     i);
-	ASSIGN(unsigned int,        123,     u);
-	ASSIGN(long,               -123,     l);
-	ASSIGN(unsigned long,       123,     u);
-	ASSIGN(long long,          -123,     l);
-	ASSIGN(unsigned long long,  123,     u);
-	ASSIGN(float,              -123.456, d);
-	ASSIGN(double,             -123.456, d);
-	ASSIGN(char const*,        "text",   s);
-	ASSIGN(std::string,        "text",   s);
-	ASSIGN(bool,               true,     b);
+	ASSIGN(short,              -123,     data.i);
+	ASSIGN(unsigned short,      123,     data.i);
+	ASSIGN(int,                -123,     data.i);
+	ASSIGN(unsigned int,        123,     data.u);
+	ASSIGN(long,               -123,     data.l);
+	ASSIGN(unsigned long,       123,     data.u);
+	ASSIGN(long long,          -123,     data.l);
+	ASSIGN(unsigned long long,  123,     data.u);
+	ASSIGN(float,              -123.456, data.d);
+	ASSIGN(double,             -123.456, data.d);
+	ASSIGN(char const*,        "text",   str_data());
+	ASSIGN(std::string,        "text",   str_data());
+	ASSIGN(bool,               true,     data.b);
 	
 	std::cout << "\n****** type cast *****\n";
 #define TYPE_CAST(TYPE, VALUE, FIELD) \
@@ -146,6 +137,642 @@ void run_tests()
 	TYPE_CAST(std::string,        "text",   s);
 	TYPE_CAST(bool,               true,     b);
 
+	std::cout << "\n****** numbers *******\n";
+#define PARSE_DOUBLE(TEXT, EXPECTED) \
+{ \
+	json::value val; \
+	val.from_string(TEXT); \
+	print_padded(TEXT, 32); \
+	compare_check(val.as<double>() == EXPECTED ? "exact" : "inexact", "exact"); \
+	std::cout << std::endl; \
+}
+	PARSE_DOUBLE("0.1",                         0.1);
+	PARSE_DOUBLE("-123.456",                    -123.456);
+	PARSE_DOUBLE("1e23",                        1e23);
+	PARSE_DOUBLE("9007199254740993.0",          9007199254740992.0);
+	PARSE_DOUBLE("2.2250738585072011e-308",     2.2250738585072011e-308);
+	PARSE_DOUBLE("4.9406564584124654e-324",     4.9406564584124654e-324);
+	PARSE_DOUBLE("1.7976931348623157e308",      1.7976931348623157e308);
+	PARSE_DOUBLE("3.14159265358979323846264338", 3.14159265358979323846264338);
+
+#define PARSE_INTEGER(TEXT, TYPE) \
+{ \
+	json::value val; \
+	val.from_string(TEXT); \
+	print_padded(TEXT, 32); \
+	compare_check(TEXT, val.to_string()); \
+	std::cout << " -> "; \
+	compare_check(json::type_string(TYPE), json::type_string(val.get_type())); \
+	std::cout << std::endl; \
+}
+	PARSE_INTEGER("2147483647",                 json::type::n_int32);
+	PARSE_INTEGER("-2147483648",                json::type::n_int32);
+	PARSE_INTEGER("2147483648",                 json::type::n_int64);
+	PARSE_INTEGER("9007199254740993",           json::type::n_int64);
+	PARSE_INTEGER("-9223372036854775808",       json::type::n_int64);
+	PARSE_INTEGER("9223372036854775808",        json::type::n_uint64);
+	PARSE_INTEGER("18446744073709551615",       json::type::n_uint64);
+
+#define WRITE_DOUBLE(VALUE, PRECISION, EXPECTED) \
+{ \
+	json::serialize_options options; \
+	options.number_precision = PRECISION; \
+	json::value val(VALUE); \
+	print_padded(#VALUE " (" #PRECISION ")", 32); \
+	compare_check(EXPECTED, val.to_string(options)); \
+	std::cout << std::endl; \
+}
+	WRITE_DOUBLE(0.1,                     -1, "0.1");
+	WRITE_DOUBLE(1e23,                    -1, "1e23");
+	WRITE_DOUBLE(5e-324,                  -1, "5e-324");
+	WRITE_DOUBLE(1.7976931348623157e308,  -1, "1.7976931348623157e308");
+	WRITE_DOUBLE(-0.000001,               -1, "-0.000001");
+	WRITE_DOUBLE(3.14159,                  2, "3.14");
+	WRITE_DOUBLE(0.999,                    2, "1");
+	WRITE_DOUBLE(-1.05,                    2, "-1.05");
+
+	std::cout << "\n****** strings *******\n";
+#define STRING(NAME, VALUE, REPLACEMENT) \
+{ \
+	std::string var = VALUE; \
+	json::value val(var); \
+	json::value copy; \
+	copy = val; \
+	json::value moved(std::move(copy)); \
+	print_padded(NAME, 20); \
+	compare_check(var, moved.as<json::string_ref>().size() == var.size() ? moved.as<std::string>() : ""); \
+	std::cout << (moved.m_short ? " -> inline" : " -> heap"); \
+	moved = REPLACEMENT; \
+	std::cout << ", "; \
+	compare_check(REPLACEMENT, moved.as<std::string const&>()); \
+	std::cout << std::endl; \
+}
+	STRING("empty",  "",                         "0123456789abcdef");
+	STRING("short",  "0123456789abc",            "");
+	STRING("long",   "0123456789abcd",           "abc");
+	STRING("longer", "0123456789abcdef01234567", "0123456789abcd");
+	{
+		json::value const heap("0123456789abcdef"), inline_string("abc");
+		std::string thrown = "none";
+		try { inline_string.as<std::string const&>(); } catch (std::exception const& e) { thrown = e.what(); }
+		print_padded("const reference", 20);
+		compare_check("0123456789abcdef string is not on the heap, use as<string_ref>()", heap.as<std::string const&>() + " " + thrown);
+		std::cout << std::endl;
+	}
+
+#define UTF8(NAME, TEXT, EXPECTED) \
+{ \
+	json::parse_options options; \
+	options.validate_utf8 = true; \
+	json::value val; \
+	std::string errors; \
+	print_padded(NAME, 20); \
+	compare_check(EXPECTED, val.from_string(TEXT, &errors, options) ? val.as<std::string>() : errors); \
+	std::cout << std::endl; \
+}
+	UTF8("utf-8",       "\"caf\xc3\xa9 \xe2\x82\xac\"",  "caf\xc3\xa9 \xe2\x82\xac");
+	UTF8("\\u escape",   "\"\\u8000\\ud83d\\ude00\"",    "\xe8\x80\x80\xf0\x9f\x98\x80");
+	UTF8("overlong",    "\"\xc0\xaf\"",                "invalid utf-8 in string at line 1");
+	UTF8("surrogate",   "\"\xed\xa0\x80\"",            "invalid utf-8 in string at line 1");
+	UTF8("truncated",   "\"abc\xe2\x82\"",             "invalid utf-8 in string at line 1");
+
+	std::cout << "\n****** objects *******\n";
+	{
+		json::value obj;
+		obj("k32728")  = 1; // same 32-bit FNV-1a hash
+		obj("k261234") = 2;
+		obj("third")   = 3;
+		print_padded("hash collision", 20);
+		compare_check("1 2 3", std::to_string(obj("k32728").as<int>()) + " " + std::to_string(obj("k261234").as<int>()) + " " + std::to_string(obj.size()));
+		std::cout << std::endl;
+
+		json::value grown;
+		for (int i=0; i<20; ++i) grown(std::to_string(i)) = i; // crosses the point where the index is built
+		int found = 0;
+		for (int i=0; i<20; ++i) found += grown(std::to_string(i)).as<int>() == i;
+		print_padded("grown", 20);
+		compare_check(20, found);
+		std::cout << std::endl;
+
+		static constexpr json::key k19("19");
+		print_padded("key", 20);
+		compare_check("19 1 0", std::to_string(grown(k19).as<int>()) + " " + std::to_string(grown.has_key("7"_key)) + " " + std::to_string(grown.has_key("20"_key)));
+		std::cout << ' ';
+		grown.remove_key(k19);
+		compare_check(false, grown.has_key(k19));
+		std::cout << std::endl;
+
+		obj.remove_key("k32728");
+		print_padded("remove", 20);
+		compare_check("k261234 third 0 2", obj.object()[0].first + " " + obj.object()[1].first + " " + std::to_string(obj.has_key("k32728")) + " " + std::to_string(obj("k261234").as<int>()));
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n******* in situ *******\n";
+	{
+		json::parse_options options;
+		options.in_situ = true;
+		json::value val;
+		char const* text = "[\"borrowed from the text\", \"escaped \\\"quotes\\\" copied\", \"short\"]";
+		val.from_string(text, nullptr, options);
+		print_padded("view", 20);
+		compare_check("borrowed from the text", val[0].as<std::string>());
+		std::cout << std::endl;
+		print_padded("escaped", 20);
+		json::string_ref escaped = val[1].as<json::string_ref>();
+		bool borrowed = escaped.data() >= text && escaped.data() < text + std::strlen(text);
+		compare_check("escaped \"quotes\" copied 0", std::string(escaped) + " " + std::to_string(borrowed));
+		std::cout << std::endl;
+		print_padded("short", 20);
+		compare_check("short", val[2].as<char const*>());
+		std::cout << std::endl;
+		print_padded("terminated", 20);
+		json::value const& shared = val;
+		std::string thrown = "none";
+		try { shared[0].as<char const*>(); } catch (std::exception const& e) { thrown = e.what(); }
+		compare_check(std::string("borrowed string is not zero terminated, use as<string_ref>() borrowed from the text"), thrown + " " + val[0].as<char const*>());
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n******** pool *********\n";
+	{
+		json::string_pool pool;
+		json::parse_options options;
+		options.pool = &pool;
+		json::value first, second;
+		first.from_string("[\"longer than inline storage\", \"short\"]", nullptr, options);
+		second.from_string("{ \"key\": \"longer than inline storage\" }", nullptr, options);
+		print_padded("shared", 20);
+		compare_check(true, first[0].as<json::string_ref>().data() == second("key").as<json::string_ref>().data());
+		std::cout << ' ';
+		compare_check(1, pool.size()); // short strings stay inline
+		std::cout << std::endl;
+
+		json::value copy = first;
+		print_padded("copy", 20);
+		compare_check(true, copy[0].as<json::string_ref>().data() != first[0].as<json::string_ref>().data());
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n****** document ******\n";
+	{
+		char const* text = "{ \"name\": \"longer than inline storage\", \"list\": [1, 2.5, \"three\", { \"four\": [true, null] }] }";
+		json::value val;
+		val.from_string(text);
+		std::string expected = val.to_string();
+
+		json::document doc;
+		for (int i=0; i<3; ++i) doc.from_string(text); // reuses the arena
+		print_padded("from_string", 20);
+		compare_check(expected, doc.root().to_string());
+		std::cout << std::endl;
+
+		doc.from_bytes(val.to_bytes());
+		print_padded("from_bytes", 20);
+		compare_check(expected, doc.root().to_string());
+		std::cout << std::endl;
+
+		json::value copy = doc.root();
+		doc.clear();
+		print_padded("copy", 20);
+		compare_check(expected, copy.to_string());
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n********* path ********\n";
+	{
+		char const* text = "{ \"skip\": { \"a\": [1, \"]}\\\"\"] }, \"users\": [{ \"id\": 1 }, { \"id\": 2, \"a/b~\": \"escaped\" }], \"none\": null }";
+		json::value val;
+		val.from_string(text);
+		json::path pointer("/users/1/a~1b~0");
+		json::path dotted("$.users[1]['a/b~']");
+		json::path id("/users/1/id");
+		json::path missing("/users/2/id");
+		print_padded("value", 20);
+		compare_check("escaped escaped 2", pointer(val).as<std::string>() + " " + dotted(val).as<std::string>() + " " + std::to_string(id(val).as<int>()));
+		std::cout << ' ';
+		compare_check("1 0", std::to_string(json::path("/none").find(val) != nullptr) + " " + std::to_string(missing.find(val) != nullptr));
+		std::cout << std::endl;
+
+		json::value result;
+		std::string errors;
+		bool found = id.find_in_json(text, result);
+		print_padded("json", 20);
+		compare_check("1 2", std::to_string(found) + " " + std::to_string(result.as<int>()));
+		std::cout << ' ';
+		compare_check(false, missing.find_in_json(text, result));
+		std::cout << ' ';
+		pointer.find_in_json(text, result);
+		compare_check("escaped", result.as<std::string>());
+		std::cout << std::endl;
+		print_padded("json error", 20);
+		id.find_in_json("{ \"skip\": \"open", result, &errors);
+		compare_check("unexpected end of string at line 1", errors);
+		std::cout << std::endl;
+
+		json::bytes_t bytes = val.to_bytes();
+		found = id.find_in_bson(bytes, result);
+		print_padded("bson", 20);
+		compare_check("1 2", std::to_string(found) + " " + std::to_string(result.as<int>()));
+		std::cout << ' ';
+		compare_check(false, missing.find_in_bson(bytes, result));
+		std::cout << ' ';
+		pointer.find_in_bson(bytes, result);
+		compare_check("escaped", result.as<std::string>());
+		std::cout << std::endl;
+
+		char const* twice = "{ \"a\": 1, \"a\": 3 }";
+		json::path("/a").find_in_json(twice, result);
+		val.from_string(twice);
+		print_padded("duplicates", 20);
+		compare_check("1 1 3", std::to_string(result.as<int>()) + " " + std::to_string(json::cursor(twice)("a").as<int>()) + " " + std::to_string(val("a").as<int>())); // scans stop at the first
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n****** parallel *******\n";
+	{
+		std::string text = "[";
+		for (int i=0; i<40000; ++i) text += (i ? ",\n" : "") + std::string("{ \"id\": ") + std::to_string(i) + ", \"tag\": \"[brackets] in a string {}\", \"list\": [1, 2.5, null] }";
+		text += "]";
+		json::parse_options options;
+		options.threads = 4;
+		json::value sequential, parallel;
+		sequential.from_string(text.c_str());
+		parallel.from_string(text.c_str(), nullptr, options);
+		print_padded("split", 20);
+		compare_check(std::string(sequential.to_string()), std::string(parallel.to_string()));
+		std::cout << std::endl;
+
+		std::string errors;
+		text.replace(text.rfind("null"), 4, "nul"); // in the last chunk
+		parallel.from_string(text.c_str(), &errors, options);
+		print_padded("error", 20);
+		compare_check("expected null at line 40000", errors);
+		std::cout << std::endl;
+
+		json::value wide;
+		for (int i=0; i<3000; ++i) wide("key" + std::to_string(i)) = sequential[i];
+		wide("empty") = json::value(json::type::array);
+		json::serialize_options single, threaded;
+		threaded.threads = 4;
+		std::string matches;
+		for (int style=0; style<3; ++style)
+		{
+			single.pretty_print = threaded.pretty_print = style != 2;
+			single.java_style_braces = threaded.java_style_braces = style == 1;
+			for (json::value const* v : { &sequential, &wide })
+			{
+				std::string expected = v->to_string(single); // to_string reuses its buffer
+				matches += std::to_string(expected == v->to_string(threaded));
+			}
+		}
+		std::ostringstream streamed;
+		sequential.write_json(streamed, threaded);
+		print_padded("write", 20);
+		compare_check("111111", matches);
+		std::cout << ' ';
+		compare_check(std::string(sequential.to_string(single)), streamed.str());
+		std::cout << std::endl;
+
+		sequential[2500]("tag") = "\xff";
+		print_padded("write error", 20);
+		try { sequential.to_string(threaded); } catch (std::exception const& ex) { errors = ex.what(); }
+		compare_check("invalid unicode symbol", errors);
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n******* cursor ********\n";
+	{
+		char const* text = " { \"skip\": [{ \"a\": \"]}\" }, 1], \"list\": [10, 20, { \"x\": true }], \"e\\u0073c\": \"decoded\" }";
+		json::cursor doc(text);
+		print_padded("lookup", 20);
+		compare_check("20 1 decoded 0", std::to_string(doc("list")[1].as<int>()) + " " + std::to_string(doc("list")[2]("x").as<bool>()) + " " + doc("esc").as<std::string>() + " " + std::to_string(doc("list")[3].exists()));
+		std::cout << ' ';
+		compare_check("[{ \"a\": \"]}\" }, 1]", std::string(doc("skip").raw().data(), doc("skip").raw().size()));
+		std::cout << std::endl;
+
+		std::string keys;
+		for (json::cursor member : doc) keys += member.key() + " ";
+		int sum = 0;
+		for (json::cursor item : doc(json::path("/list"))) sum += item.is_number() ? item.as<int>() : 0;
+		print_padded("iterate", 20);
+		compare_check("skip list esc 30", keys + std::to_string(sum));
+		std::cout << std::endl;
+
+		json::value val;
+		std::string errors;
+		print_padded("error", 20);
+		compare_check(false, json::cursor("[1, ")[1].exists());
+		std::cout << ' ';
+		json::cursor("{ \"a\": [1, }")("a").get(val, &errors);
+		compare_check("invalid numeric value at line 1", errors);
+		std::cout << std::endl;
+
+		std::string owned = "{ \"list\": [1, 2345678901234] }"; // lengths are known, no strlen pass
+		json::cursor sized(owned);
+		json::value parsed;
+		print_padded("length", 20);
+		compare_check(true, parsed.from_string(owned) && parsed("list")[1].as<int64_t>() == sized("list")[1].as<int64_t>());
+		std::cout << ' ';
+		compare_check(true, parsed.from_string(owned.c_str(), owned.size()) && parsed("list")[1].as<int64_t>() == 2345678901234);
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n****** bson view ******\n";
+	{
+		json::value val;
+		val.from_string("{ \"skip\": { \"deep\": [1, 2, 3] }, \"list\": [10, \"longer than inline storage\", { \"x\": true }], \"n\": 7 }");
+		json::bytes_t bytes = val.to_bytes();
+		json::bson_view doc(bytes);
+		json::string_ref text = doc("list")[1].as<json::string_ref>();
+		print_padded("lookup", 20);
+		compare_check("7 10 1 0", std::to_string(doc("n").as<int>()) + " " + std::to_string(doc("list")[0].as<int>()) + " " + std::to_string(doc(json::path("/list/2/x")).as<bool>()) + " " + std::to_string(doc("list")[3].exists()));
+		std::cout << ' ';
+		compare_check(true, text.data() > bytes.data() && text.data() < bytes.data() + bytes.size()); // in place
+		std::cout << std::endl;
+
+		std::string keys;
+		for (json::bson_view element : doc) keys += std::string(element.key().data(), element.key().size()) + " ";
+		print_padded("iterate", 20);
+		compare_check("skip list n ", keys);
+		std::cout << ' ';
+		std::string skip = val("skip").to_string();
+		compare_check(skip, doc("skip").get().to_string());
+		std::cout << std::endl;
+
+		json::value large;
+		for (int i=0; i<1500; ++i) large("list")[i] = i; // index keys past the table
+		large("name") = "text";
+		std::vector<char> buffer(large.bson_size());
+		json::value decoded;
+		decoded.from_bytes(buffer.data(), large.to_bytes(buffer.data(), buffer.size()));
+		std::string expected = large.to_string();
+		print_padded("into buffer", 20);
+		compare_check(expected, decoded.to_string());
+		std::cout << ' ';
+		compare_check("0 1499", std::to_string(large.to_bytes(buffer.data(), buffer.size() - 1)) + " " + json::bson_view(buffer.data(), buffer.size())("list")[1499].key().data());
+		std::cout << std::endl;
+
+		bytes[bytes.size() - 9] = 0x7f; // "n" becomes an unknown type
+		print_padded("damaged", 20);
+		compare_check("0 1 0", std::to_string(json::bson_view(bytes)("n").exists()) + " " + std::to_string(json::bson_view(bytes)("skip").exists()) + " " + std::to_string(json::bson_view(bytes.data(), 40).exists()));
+		std::cout << std::endl;
+
+		json::bytes_t blob = { 14, 0, 0, 0, 5, 'b', 0, '\xf0', '\xff', '\xff', '\x7f', 0, 'x', 0 }; // declares a 2 GB binary
+		std::string errors;
+		print_padded("binary size", 20);
+		compare_check("0 end of data reached", std::to_string(decoded.from_bytes(blob, &errors)) + " " + errors);
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n***** bson stream *****\n";
+	{
+		json::bytes_t log;
+		std::size_t last = 0;
+		for (int i=0; i<50; ++i)
+		{
+			last = log.size();
+			json::value record;
+			record("seq") = i;
+			record("text") = std::string(i, 'x');
+			json::bytes_t bytes = record.to_bytes();
+			log.insert(log.end(), bytes.begin(), bytes.end());
+		}
+
+		json::bson_stream views(log);
+		int sum = 0;
+		for (json::bson_view record = views.next(); record.exists(); record = views.next()) sum += record("seq").as<int>();
+		print_padded("views", 20);
+		compare_check("1225 1", std::to_string(sum) + " " + std::to_string(views.offset() == log.size() && views.errors().empty()));
+		std::cout << std::endl;
+
+		std::string order;
+		auto append = [&](json::value& record) { order += std::to_string(record("seq").as<int>() == (int)order.size() % 50); return true; };
+		std::istringstream in(std::string(log.data(), log.size()));
+		json::bson_stream stream(in);
+		bool ok = stream.decode(append, 4);
+		print_padded("decode", 20);
+		compare_check(true, ok && json::bson_stream(log).decode(append, 1));
+		std::cout << ' ';
+		compare_check(std::string(100, '1'), order);
+		std::cout << std::endl;
+
+		log.resize(log.size() - 3);
+		print_padded("damaged", 20);
+		for (unsigned threads : { 1, 4 })
+		{
+			if (threads > 1) std::cout << ' ';
+			int delivered = 0;
+			json::bson_stream damaged(log);
+			ok = damaged.decode([&](json::value&) { ++delivered; return true; }, threads);
+			compare_check("0 49", std::to_string(ok) + " " + std::to_string(delivered)); // the documents before the damage still arrive
+			std::cout << ' ';
+			compare_check("damaged document at offset " + std::to_string(last), damaged.errors());
+		}
+		std::cout << std::endl;
+
+		std::istringstream huge(std::string("\xff\xff\xff\x7f" "abc")); // declares a 2 GB document
+		json::bson_stream head(huge);
+		std::istringstream small(std::string(log.data(), log.size()));
+		json::bson_stream limited(small);
+		limited.set_max_size(16);
+		print_padded("lengths", 20);
+		compare_check("0 damaged document at offset 0", std::to_string(head.next().exists()) + " " + head.errors());
+		std::cout << ' ';
+		compare_check("0 damaged document at offset 0", std::to_string(limited.next().exists()) + " " + limited.errors());
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n**** msgpack, cbor ****\n";
+	{
+		json::value val;
+		val.from_string("{ \"a\": [1, -1, 300] }");
+		json::bytes_t msgpack = val.to_msgpack();
+		json::bytes_t cbor = val.to_cbor();
+		print_padded("encode", 20);
+		compare_check(std::string("\x81\xa1" "a" "\x93\x01\xff\xcd\x01\x2c", 9), std::string(msgpack.data(), msgpack.size()));
+		std::cout << ' ';
+		compare_check(std::string("\xa1" "aa" "\x83\x01\x20\x19\x01\x2c", 9), std::string(cbor.data(), cbor.size()));
+		std::cout << std::endl;
+
+		json::value all;
+		all.from_string("{ \"n\": null, \"t\": true, \"small\": -5, \"int\": -100000, \"long\": -5000000000, \"half\": 0.5, \"tenth\": 0.1, \"text\": \"longer than inline storage\", \"list\": [[], {}, 1e300] }");
+		all("big") = UINT64_MAX;
+		all("blob") = json::bytes_t(300, 'x');
+		for (int i=0; i<20; ++i) all("list")[1](std::to_string(i)) = i * 1000; // past the object index threshold
+		std::string expected = all.to_string();
+		json::value decoded;
+		bool ok = decoded.from_msgpack(all.to_msgpack());
+		print_padded("round trip", 20);
+		compare_check(true, ok && decoded.to_string() == expected && decoded("big").is_uint64() && decoded("long").is_int64() && decoded("half").is_double() && decoded("blob").as<json::bytes_t>() == json::bytes_t(300, 'x'));
+		std::cout << ' ';
+		ok = decoded.from_cbor(all.to_cbor());
+		compare_check(true, ok && decoded.to_string() == expected && decoded("big").is_uint64() && decoded("long").is_int64() && decoded("half").is_double() && decoded("blob").as<json::bytes_t>() == json::bytes_t(300, 'x'));
+		std::cout << std::endl;
+
+		std::vector<char> buffer(all.cbor_size());
+		print_padded("into buffer", 20);
+		compare_check("0 1", std::to_string(all.to_cbor(buffer.data(), buffer.size() - 1)) + " " + std::to_string(all.to_cbor(buffer.data(), buffer.size()) == buffer.size()));
+		std::cout << ' ';
+		compare_check(all.to_msgpack().size(), all.msgpack_size());
+		std::cout << std::endl;
+
+		// [1.0 as a half float, tag 1 on 1, "abc" in two chunks, { "k": 1 }], all of indefinite length
+		json::bytes_t chunked = { '\x9f', '\xf9', '\x3c', '\x00', '\xc1', '\x1a', 0, 0, 0, 1, '\x7f', '\x62', 'a', 'b', '\x61', 'c', '\xff', '\xbf', '\x61', 'k', 1, '\xff', '\xff' };
+		decoded.from_cbor(chunked);
+		print_padded("cbor forms", 20);
+		compare_check("1 1 abc 1", std::to_string(int(decoded[0].as<double>())) + " " + std::to_string(decoded[1].as<int>()) + " " + decoded[2].as<std::string>() + " " + std::to_string(decoded[3]("k").as<int>()));
+		std::cout << std::endl;
+
+		json::parse_options options;
+		options.in_situ = true;
+		json::document doc;
+		ok = doc.from_cbor(buffer, nullptr, options);
+		json::string_ref text = doc.root()("text").as<json::string_ref>();
+		print_padded("in situ", 20);
+		compare_check(true, ok && text.data() > buffer.data() && text.data() < buffer.data() + buffer.size());
+		std::cout << ' ';
+		compare_check("longer than inline storage", doc.root()("text").as<std::string>());
+		std::cout << std::endl;
+
+		std::string errors;
+		print_padded("errors", 20);
+		decoded.from_msgpack(msgpack.data(), msgpack.size() - 1, &errors);
+		compare_check("end of data reached", errors);
+		std::cout << ' ';
+		decoded.from_msgpack("\x81\x01\x01", 3, &errors);
+		compare_check("map keys must be strings", errors);
+		std::cout << ' ';
+		decoded.from_cbor("\x9b\xff\xff\xff\xff\xff\xff\xff\xff", 9, &errors); // a count the data can't hold
+		compare_check("end of data reached", errors);
+		std::cout << ' ';
+		decoded.from_cbor("\x01\x01", 2, &errors);
+		compare_check("unexpected data after value", errors);
+		std::cout << std::endl;
+
+		std::string tags(100000, '\xc6'), arrays(100000, '\x91'), nested(511, '\x81');
+		tags += '\x01'; arrays += '\x01'; nested += '\x01';
+		print_padded("depth", 20);
+		decoded.from_cbor(tags.data(), tags.size(), &errors);
+		compare_check("invalid nesting depth", errors);
+		std::cout << ' ';
+		decoded.from_msgpack(arrays.data(), arrays.size(), &errors);
+		compare_check("invalid nesting depth", errors);
+		std::cout << ' ';
+		compare_check(true, decoded.from_cbor(nested.data(), nested.size())); // 512 levels
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n********* sax *********\n";
+	{
+		struct trace : sax_handler
+		{
+			std::string out;
+			bool null()                    { out += "z "; return true; }
+			bool boolean(bool b)           { out += b ? "t " : "f "; return true; }
+			bool number(value const& n)    { out += type_string(n.get_type()); out += ' '; return true; }
+			bool string(string_ref const& s) { out.append(s.data(), s.size()) += ' '; return true; }
+			bool key(string_ref const& k)  { out.append(k.data(), k.size()) += ": "; return true; }
+			bool start_object()            { out += "{ "; return true; }
+			bool end_object()              { out += "} "; return true; }
+			bool start_array()             { out += "[ "; return true; }
+			bool end_array()               { out += "] "; return true; }
+		};
+
+		trace events;
+		sax_parse("{ \"a\": [1, 2.5, \"x\\ty\", { \"b\": [true, null] }], \"c\": 9223372036854775808 }", events);
+		print_padded("events", 20);
+		compare_check("{ a: [ int32 double x\ty { b: [ t z ] } ] c: uint64 } ", events.out);
+		std::cout << std::endl;
+
+		struct first_key : sax_handler
+		{
+			std::string found;
+			bool key(string_ref const& k) { found.assign(k.data(), k.size()); return false; }
+		};
+
+		first_key stop;
+		std::string errors;
+		bool complete = sax_parse("{ \"a\": 1, \"b\": [", stop, &errors);
+		print_padded("stop", 20);
+		compare_check("a stopped by handler 0", stop.found + " " + errors + " " + (complete ? "1" : "0"));
+		std::cout << std::endl;
+
+		print_padded("error", 20);
+		compare_check("missing comma in array at line 2", (sax_parse("[1,\n2 3]", events, &errors), errors));
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n**** push parser *****\n";
+	{
+		char const* text = "{ \"text\": \"caf\\u00e9 \\ud83d\\ude00\", \"list\": [-12.5e1, 18446744073709551615, true, null, {}] }";
+		json::value val;
+		val.from_string(text);
+		std::string expected = val.to_string();
+
+		value_builder builder;
+		push_parser<value_builder> parser(builder);
+		for (char const* p = text; *p; ++p) parser.feed(p, 1); // every boundary, including inside escapes and numbers
+		print_padded("byte by byte", 20);
+		compare_check(expected, parser.finish() ? builder.result().to_string() : parser.errors());
+		std::cout << std::endl;
+
+		value_builder top_builder;
+		push_parser<value_builder> top(top_builder);
+		top.feed("12", 2);
+		top.feed("34", 2);
+		print_padded("finish", 20);
+		compare_check("1234", top.finish() ? top_builder.result().to_string() : top.errors());
+		std::cout << std::endl;
+
+		std::vector<char> chunk = { '[', '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '1', '2', ',' }; // not terminated, no room after it
+		value_builder chunk_builder;
+		push_parser<value_builder> chunked(chunk_builder);
+		chunked.feed(chunk.data(), chunk.size());
+		chunked.feed("7]", 2);
+		print_padded("chunk end", 20);
+		compare_check("123456789012 7", chunked.finish() ? std::to_string(chunk_builder.result()[0].as<int64_t>()) + " " + std::to_string(chunk_builder.result()[1].as<int>()) : chunked.errors());
+		std::cout << std::endl;
+
+		value_builder bad_builder;
+		push_parser<value_builder> bad(bad_builder);
+		bad.feed("[1,\n2 ", 6);
+		bad.feed("3]", 2);
+		print_padded("error", 20);
+		compare_check("missing comma in array at line 2", bad.errors());
+		std::cout << std::endl;
+	}
+
+	std::cout << "\n****** streaming *****\n";
+	{
+		json::value val;
+		for (int i=0; i<20000; ++i) val.append(value("string longer than inline storage"));
+		std::string expected = val.to_string();
+
+		std::ostringstream oss;
+		print_padded("ostream", 20);
+		compare_check(expected, val.write_json(oss) ? oss.str() : "failed");
+		std::cout << std::endl;
+
+		struct pieces { std::string text; int count = 0; } out;
+		val.write_json([](void* context, char const* data, std::size_t size)
+		{
+			pieces* out = static_cast<pieces*>(context);
+			out->text.append(data, size);
+			++out->count;
+			return true;
+		}, &out);
+		print_padded("sink", 20);
+		compare_check(expected, out.text);
+		std::cout << ' ';
+		compare_check(out.count > 1, true);
+		std::cout << std::endl;
+
+		print_padded("sink failure", 20);
+		compare_check(false, val.write_json([](void*, char const*, std::size_t) { return false; }, nullptr));
+		std::cout << std::endl;
+	}
+
 #if TEST_LEAKS != 0
 	std::cout << "\n******* memory *******\n";
 	if (g_allocs > 0) std::cout << g_allocs << " leaked objects";